@@ -0,0 +1,213 @@
+//
+// Allocator.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "Allocator.hpp"
+
+#include <cstdlib>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define ECS_HAS_MMAP 1
+#endif
+
+namespace ecs {
+
+namespace {
+
+/// \brief Rounds a size up to a multiple of a power of two
+inline size_t round_up(size_t size, size_t multiple)
+{
+  return (size + multiple - 1) & ~(multiple - 1);
+}
+
+}
+
+void* allocate_aligned(size_t bytes, size_t align)
+{
+  void* ptr = nullptr;
+  if ( align < sizeof(void*) )
+    align = sizeof(void*);
+
+#if defined(_WIN32)
+  ptr = _aligned_malloc(bytes > 0 ? bytes : 1, align);
+#else
+  if ( posix_memalign(&ptr, align, bytes > 0 ? bytes : 1) != 0 )
+    ptr = nullptr;
+#endif
+
+  if ( ptr == nullptr )
+    throw std::bad_alloc();
+
+  return ptr;
+}
+
+void deallocate_aligned(void* ptr)
+{
+#if defined(_WIN32)
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
+void* allocate_pages(size_t bytes, bool hugePages)
+{
+#ifdef ECS_HAS_MMAP
+  void* ptr = MAP_FAILED;
+  auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef __linux__
+  if ( hugePages ) {
+    // Explicit huge pages only work if the admin reserved some
+    ptr = mmap(nullptr, round_up(bytes, huge_page_size), PROT_READ | PROT_WRITE,
+               flags | MAP_HUGETLB, -1, 0);
+    if ( ptr != MAP_FAILED )
+      return ptr;
+  }
+#endif
+
+  auto size = round_up(bytes, hugePages ? huge_page_size : getpagesize());
+  ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if ( ptr == MAP_FAILED )
+    throw std::bad_alloc();
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if ( hugePages )
+    madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+
+  return ptr;
+#else
+  (void)hugePages;
+  return allocate_aligned(bytes, 4096);
+#endif
+}
+
+void deallocate_pages(void* ptr, size_t bytes, bool hugePages)
+{
+  if ( ptr == nullptr )
+    return;
+
+#ifdef ECS_HAS_MMAP
+  // Both huge and regular mappings were rounded to huge pages when requested
+  munmap(ptr, round_up(bytes, hugePages ? huge_page_size : getpagesize()));
+#else
+  (void)bytes;
+  (void)hugePages;
+  deallocate_aligned(ptr);
+#endif
+}
+
+BlockPool::BlockPool(size_t blockSize, size_t slabSize, bool hugePages)
+  : blockSize_(round_up(blockSize, cache_line_size)),
+    slabSize_(slabSize),
+    hugePages_(hugePages)
+{
+  if ( slabSize_ < blockSize_ )
+    slabSize_ = blockSize_;
+}
+
+BlockPool::~BlockPool()
+{
+  for ( auto slab : slabs_ )
+    deallocate_pages(slab, slabSize_, hugePages_);
+}
+
+void* BlockPool::allocate()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if ( free_.empty() ) {
+    auto slab = static_cast<unsigned char*>(allocate_pages(slabSize_, hugePages_));
+    slabs_.push_back(slab);
+
+    // Push in reverse so blocks are handed out in address order
+    auto count = slabSize_ / blockSize_;
+    for ( size_t b = count; b > 0; --b )
+      free_.push_back(slab + (b - 1) * blockSize_);
+  }
+
+  auto block = free_.back();
+  free_.pop_back();
+  return block;
+}
+
+void BlockPool::deallocate(void* block)
+{
+  if ( block == nullptr )
+    return;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_.push_back(block);
+}
+
+size_t BlockPool::reserved() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return slabs_.size() * slabSize_;
+}
+
+BlockPool& BlockPool::chunks()
+{
+  // Never destroyed so archetypes in static storage can still return chunks
+  static auto pool = new BlockPool(16 * 1024);
+  return *pool;
+}
+
+FrameArena::FrameArena(size_t capacity, bool hugePages)
+  : data_(static_cast<unsigned char*>(allocate_pages(capacity, hugePages))),
+    capacity_(capacity),
+    used_(0),
+    hugePages_(hugePages),
+    overflowUsed_(0) {}
+
+FrameArena::~FrameArena()
+{
+  // Only free, reset() would grow the main block first after an overflow
+  for ( auto block : overflow_ )
+    deallocate_aligned(block);
+  deallocate_pages(data_, capacity_, hugePages_);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t align)
+{
+  auto offset = round_up(used_, align);
+  if ( offset + bytes <= capacity_ ) {
+    used_ = offset + bytes;
+    return data_ + offset;
+  }
+
+  // Out of room this frame, fall back to a separate block
+  auto block = allocate_aligned(bytes, align > cache_line_size ? align : cache_line_size);
+  overflow_.push_back(block);
+  overflowUsed_ += bytes;
+  return block;
+}
+
+void FrameArena::reset()
+{
+  if ( !overflow_.empty() ) {
+    for ( auto block : overflow_ )
+      deallocate_aligned(block);
+    overflow_.clear();
+
+    // Grow so a frame like the last one fits without overflowing
+    auto capacity = capacity_ + overflowUsed_ + overflowUsed_ / 2;
+    deallocate_pages(data_, capacity_, hugePages_);
+    data_ = static_cast<unsigned char*>(allocate_pages(capacity, hugePages_));
+    capacity_ = capacity;
+    overflowUsed_ = 0;
+  }
+
+  used_ = 0;
+}
+
+}
@@ -0,0 +1,215 @@
+//
+// Allocator.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_ALLOCATOR_HPP
+#define ECS_FRAMEWORK_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "JobPool.hpp"
+
+namespace ecs {
+
+/// \brief Size of a huge page on the platforms that support them
+constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+/// \brief Allocates memory aligned to a power of two
+/// \param bytes Number of bytes to allocate
+/// \param align Alignment of the returned pointer
+/// \return Pointer to the memory. Throws std::bad_alloc on failure
+void* allocate_aligned(size_t bytes, size_t align = cache_line_size);
+
+/// \brief Frees memory from allocate_aligned()
+/// \param ptr Pointer to free, may be nullptr
+void deallocate_aligned(void* ptr);
+
+/// \brief Maps whole pages of memory directly from the OS. With hugePages set
+/// explicit huge pages (MAP_HUGETLB) are tried first, falling back to asking
+/// for transparent huge pages, so large tables don't thrash the TLB
+/// \param bytes Number of bytes to map, rounded up to whole pages
+/// \param hugePages True to back the mapping with huge pages where possible
+/// \return Pointer to the page aligned memory. Throws std::bad_alloc on
+/// failure
+void* allocate_pages(size_t bytes, bool hugePages);
+
+/// \brief Unmaps memory from allocate_pages()
+/// \param ptr Pointer to unmap, may be nullptr
+/// \param bytes Number of bytes passed to allocate_pages()
+/// \param hugePages Value passed to allocate_pages()
+void deallocate_pages(void* ptr, size_t bytes, bool hugePages);
+
+/// \brief AlignedAllocator is a standard allocator returning memory aligned to
+/// Align bytes, cache lines by default, so SIMD loads over component arrays
+/// never split a line
+/// \tparam T Type of value to allocate
+/// \tparam Align Alignment of each allocation
+template <typename T, size_t Align = cache_line_size>
+struct AlignedAllocator {
+  static_assert(Align >= alignof(T), "Align must satisfy the types alignment");
+
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Align>;
+  };
+
+  AlignedAllocator() = default;
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+  /// \brief Allocates room for count values
+  inline T* allocate(size_t count)
+  {
+    if ( count > std::numeric_limits<size_t>::max() / sizeof(T) )
+      throw std::bad_alloc();
+
+    return static_cast<T*>(allocate_aligned(count * sizeof(T), Align));
+  }
+
+  /// \brief Frees values from allocate()
+  inline void deallocate(T* ptr, size_t)
+  {
+    deallocate_aligned(ptr);
+  }
+};
+
+template <typename T, typename U, size_t Align>
+inline bool operator==(const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>&)
+{
+  return true;
+}
+
+template <typename T, typename U, size_t Align>
+inline bool operator!=(const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>&)
+{
+  return false;
+}
+
+/// \brief A vector whose storage is cache line aligned
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+/// \brief BlockPool hands out fixed-size, cache line aligned blocks carved
+/// from large slabs. Blocks never move once allocated and freed blocks are
+/// reused before a new slab is mapped, so steady-state churn never reaches the
+/// system allocator. Thread safe
+class BlockPool {
+public:
+  /// \brief Initializes an empty pool
+  /// \param blockSize Size of each block in bytes, rounded up to cache lines
+  /// \param slabSize Size of each slab mapped from the OS. Rounded up to hold
+  /// at least one block
+  /// \param hugePages True to back slabs with huge pages where possible
+  BlockPool(size_t blockSize, size_t slabSize = huge_page_size, bool hugePages = true);
+
+  /// \brief Unmaps every slab. All blocks must have been returned
+  ~BlockPool();
+
+  BlockPool(const BlockPool&) = delete;
+  BlockPool& operator=(const BlockPool&) = delete;
+
+  /// \brief Gets a block, mapping a new slab if none are free
+  /// \return Pointer to the block
+  void* allocate();
+
+  /// \brief Returns a block to the pool
+  /// \param block Block from allocate()
+  void deallocate(void* block);
+
+  /// \brief Gets the size of each block
+  /// \return Block size in bytes
+  inline size_t block_size() const { return blockSize_; }
+
+  /// \brief Gets the number of bytes mapped for slabs
+  /// \return Bytes reserved from the OS
+  size_t reserved() const;
+
+  /// \brief Gets the pool shared by every Archetype for its chunks
+  /// \return The chunk pool
+  static BlockPool& chunks();
+
+private:
+  size_t blockSize_;
+  size_t slabSize_;
+  bool hugePages_;
+  mutable std::mutex mutex_;
+  std::vector<void*> slabs_;
+  std::vector<void*> free_;
+};
+
+/// \brief FrameArena is a linear allocator for scratch data that only lives
+/// until the end of a frame, such as temporary system outputs. Allocating
+/// bumps a pointer and reset() frees everything at once. When a frame needs
+/// more than the arena holds, overflow blocks are used and the arena grows to
+/// fit on the next reset, so it settles at the high-water mark. Not thread
+/// safe, give each thread its own arena
+class FrameArena {
+public:
+  /// \brief Initializes an arena
+  /// \param capacity Initial size in bytes
+  /// \param hugePages True to back the arena with huge pages where possible
+  explicit FrameArena(size_t capacity = huge_page_size, bool hugePages = false);
+
+  /// \brief Frees the arena and any overflow blocks
+  ~FrameArena();
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  /// \brief Allocates memory that stays valid until the next reset()
+  /// \param bytes Number of bytes to allocate
+  /// \param align Alignment of the returned pointer
+  /// \return Pointer to the memory
+  void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+  /// \brief Allocates uninitialized room for values that stay valid until the
+  /// next reset(). Destructors are never run, so use trivially destructible
+  /// types
+  /// \tparam T Type of value
+  /// \param count Number of values
+  /// \return Pointer to the first value
+  template <typename T>
+  inline T* allocate(size_t count)
+  {
+    return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+  }
+
+  /// \brief Frees every allocation made since the last reset. Constant time
+  /// unless the last frame overflowed
+  void reset();
+
+  /// \brief Gets the number of bytes allocated since the last reset
+  /// \return Bytes in use
+  inline size_t used() const { return used_ + overflowUsed_; }
+
+  /// \brief Gets the size of the main block
+  /// \return Capacity in bytes
+  inline size_t capacity() const { return capacity_; }
+
+private:
+  unsigned char* data_;
+  size_t capacity_;
+  size_t used_;
+  bool hugePages_;
+  /// \brief Blocks allocated this frame once the main block was full
+  std::vector<void*> overflow_;
+  size_t overflowUsed_;
+};
+
+}
+
+#endif //ECS_FRAMEWORK_ALLOCATOR_HPP
@@ -0,0 +1,1074 @@
+//
+// Benchmark.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+// Headless benchmark of the update and collision parts of the raw, OO and ECS
+// experiments in Main.cpp. Nothing is rendered so no window or GPU is needed.
+//
+// Usage: Benchmark [--entities 1000,10000,100000,1000000] [--warmup 10]
+//                  [--samples 20] [--frames 60] [--output data.csv]
+//                  [--summary summary.csv] [--threads 0]
+//
+// The raw and OO baselines are single threaded, so the ECS runs its parallel
+// loops on the calling thread too unless --threads gives the shared job pool
+// workers. The Threads column of both CSVs records the threads each
+// experiment ran on.
+//
+// Passing --churn replaces the frame experiments with a seeded random mix of
+// creates, destroys, attaches and removes, starting from each --entities
+// population. --rates weights the four operations in that order. Every
+// operation is timed and checked against a model of which handles should be
+// alive and what their components should hold. Operations that no entity
+// can take, such as removes when nothing is attached, are skipped, so the
+// rates that actually ran are printed next to the configured ones.
+//
+// Usage: Benchmark --churn 1000000 [--entities 1000,100000] [--rates 1,1,2,2]
+//                  [--seed 1] [--summary summary.csv]
+//
+// Passing --batch N instead times build_sprite_batches over each --entities
+// population of sprites spread across N empty textures, first interleaved so
+// neighbouring sprites never share a texture and then after
+// SpriteSystem::sort_by_texture has grouped them. No texture is uploaded, so
+// this measures only the CPU side of batching.
+//
+// Usage: Benchmark --batch 8 [--entities 1000,100000] [--warmup 10]
+//                  [--samples 20] [--frames 60] [--summary summary.csv]
+//
+// Passing --check runs behavioural checks of the framework's invariants
+// instead of timing anything: sparse set pages and entity generations,
+// command buffer playback order, sort_step convergence, snapshot ring
+// rewinds, broad-phase pairs against a brute force search and hierarchy
+// world transforms against walking each entity's parent chain. The exit
+// code is non-zero if any check fails.
+//
+// Usage: Benchmark --check [--seed 1]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include <GameObject.hpp>
+#include <Entity.hpp>
+#include <Collision.hpp>
+#include <Hierarchy.hpp>
+#include <Snapshot.hpp>
+#include <Sprite.hpp>
+#include <Transform.hpp>
+
+namespace {
+
+/// \brief Benchmark settings parsed from the command line
+struct Options {
+  std::vector<int> entities { 1000, 10000, 100000, 1000000 };
+  int warmup = 10;
+  int samples = 20;
+  int frames = 60;
+  std::string output = "data.csv";
+  std::string summary = "summary.csv";
+  /// Operations per population in churn mode, 0 to run the frame experiments
+  int churn = 0;
+  /// Relative weights of create, destroy, attach and remove in churn mode
+  std::vector<int> rates { 1, 1, 1, 1 };
+  /// Seed for the churn workload, so runs can be repeated exactly
+  unsigned seed = 1;
+  /// Workers in the shared job pool, 0 to run the ECS single threaded like
+  /// the baselines
+  int threads = 0;
+  /// Textures to spread sprites over in batching mode, 0 to run the frame
+  /// experiments
+  int batch = 0;
+  /// Run the behavioural checks rather than any benchmark
+  bool check = false;
+};
+
+/// \brief Frame time statistics for one experiment and entity count
+struct Summary {
+  double mean, stddev, p50, p95, p99, max;
+};
+
+/// \brief Gets a percentile from a sorted vector of frame times
+double percentile(const std::vector<double>& sorted, double p)
+{
+  auto index = static_cast<size_t>(std::ceil(p * sorted.size())) - 1;
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/// \brief Computes statistics over individual frame times
+Summary summarize(std::vector<double> times)
+{
+  std::sort(times.begin(), times.end());
+
+  double total = 0;
+  for ( auto t : times )
+    total += t;
+
+  Summary s;
+  s.mean = total / times.size();
+
+  double variance = 0;
+  for ( auto t : times )
+    variance += (t - s.mean) * (t - s.mean);
+
+  s.stddev = std::sqrt(variance / times.size());
+  s.p50 = percentile(times, 0.50);
+  s.p95 = percentile(times, 0.95);
+  s.p99 = percentile(times, 0.99);
+  s.max = times.back();
+  return s;
+}
+
+/// \brief Parses a comma separated list of integers
+std::vector<int> parse_counts(const std::string& list)
+{
+  std::vector<int> counts;
+  std::stringstream stream(list);
+  std::string item;
+  while ( std::getline(stream, item, ',') )
+    counts.push_back(std::atoi(item.c_str()));
+  return counts;
+}
+
+Options parse_options(int argc, char** argv)
+{
+  Options options;
+  for ( int i = 1; i < argc; ++i ) {
+    std::string flag = argv[i];
+
+    // Switches take no value
+    if ( flag == "--check" ) {
+      options.check = true;
+      continue;
+    }
+
+    if ( i + 1 >= argc ) {
+      std::cerr << "Missing value for " << flag << "\n";
+      break;
+    }
+    std::string value = argv[++i];
+
+    if ( flag == "--entities" )
+      options.entities = parse_counts(value);
+    else if ( flag == "--warmup" )
+      options.warmup = std::atoi(value.c_str());
+    else if ( flag == "--samples" )
+      options.samples = std::atoi(value.c_str());
+    else if ( flag == "--frames" )
+      options.frames = std::atoi(value.c_str());
+    else if ( flag == "--output" )
+      options.output = value;
+    else if ( flag == "--summary" )
+      options.summary = value;
+    else if ( flag == "--churn" )
+      options.churn = std::atoi(value.c_str());
+    else if ( flag == "--rates" )
+      options.rates = parse_counts(value);
+    else if ( flag == "--seed" )
+      options.seed = static_cast<unsigned>(std::atoi(value.c_str()));
+    else if ( flag == "--threads" )
+      options.threads = std::max(0, std::atoi(value.c_str()));
+    else if ( flag == "--batch" )
+      options.batch = std::max(0, std::atoi(value.c_str()));
+    else
+      std::cerr << "Unknown option " << flag << "\n";
+  }
+  return options;
+}
+
+/// \brief Runs one experiment, recording a data.csv row per sample and
+/// returning every individual frame time
+/// \param experiment Experiment number as used by Main.cpp and plots.py
+/// \param numEntities Entity count, written to the Entities column
+/// \param threads Threads the experiment runs on, written to the Threads
+/// column
+/// \param frame Function running one frame of the experiment
+std::vector<double> run(const Options& options, int experiment, int numEntities,
+                        int threads, const std::function<void()>& frame,
+                        std::ofstream& csv)
+{
+  using Clock = std::chrono::steady_clock;
+
+  for ( int w = 0; w < options.warmup; ++w )
+    frame();
+
+  std::vector<double> times;
+  times.reserve(options.samples * options.frames);
+
+  for ( int sample = 0; sample < options.samples; ++sample ) {
+    double sampleTotal = 0;
+
+    for ( int f = 0; f < options.frames; ++f ) {
+      auto start = Clock::now();
+      frame();
+      auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      times.push_back(seconds);
+      sampleTotal += seconds;
+    }
+
+    csv << experiment << "," << sample << ","
+        << sampleTotal / options.frames << "," << numEntities << ","
+        << threads << "\n";
+  }
+
+  return times;
+}
+
+/// \brief Churn benchmark operations, in the order of Options::rates
+enum ChurnOp { churn_create, churn_destroy, churn_attach, churn_remove, churn_ops };
+
+/// \brief An entity the churn benchmark expects to be alive, and what it
+/// expects the entity to hold
+struct LiveEntity {
+  ecs::Entity entity;
+  /// Unique value written into each of the entities components on attach
+  uint32_t payload;
+  /// Systems the entity should belong to
+  uint64_t signature;
+};
+
+/// \brief Churn benchmark state: the world being churned and a model of what
+/// it should contain
+struct ChurnWorld {
+  ecs::EntityMap ecs;
+  ecs::MovementSystem* movement;
+  ecs::CollisionSystem* collision;
+  /// Systems an entity can be attached to
+  uint64_t masks[2];
+  /// Entities that should be alive, in no particular order
+  std::vector<LiveEntity> live;
+  /// Recently destroyed handles, which must never resolve again
+  std::vector<ecs::Entity> stale;
+  size_t staleNext = 0;
+  uint32_t nextPayload = 0;
+
+  ChurnWorld()
+  {
+    movement = ecs.add_system<ecs::MovementSystem>();
+    collision = ecs.add_system<ecs::CollisionSystem>();
+    masks[0] = ecs::system_mask<ecs::MovementSystem>();
+    masks[1] = ecs::system_mask<ecs::CollisionSystem>();
+    stale.reserve(4096);
+  }
+
+  /// \brief Writes an entities payload into a component. Floats hold the
+  /// payload exactly as two 16 bit halves
+  void write(const LiveEntity& live, uint64_t mask)
+  {
+    sf::Vector2f value(live.payload & 0xffff, live.payload >> 16);
+    if ( mask == masks[0] ) {
+      ecs::Transform transform;
+      transform.position = value;
+      movement->transforms.set(live.entity, transform);
+    } else {
+      collision->boxes.set(live.entity, sf::FloatRect(value.x, value.y, 0, 0));
+    }
+  }
+
+  /// \brief Remembers a destroyed handle, replacing the oldest once full
+  void retire(const ecs::Entity& entity)
+  {
+    if ( stale.size() < stale.capacity() ) {
+      stale.push_back(entity);
+    } else {
+      stale[staleNext] = entity;
+      staleNext = (staleNext + 1) % stale.size();
+    }
+  }
+
+  /// \brief Checks a live entity resolves to its own components and only
+  /// the systems it was attached to
+  bool verify(const LiveEntity& live) const
+  {
+    auto& e = live.entity;
+    if ( !ecs.is_alive(e) || ecs.signature(e) != live.signature )
+      return false;
+
+    sf::Vector2f value(live.payload & 0xffff, live.payload >> 16);
+
+    auto moves = (live.signature & masks[0]) != 0;
+    if ( movement->transforms.has_component(e) != moves )
+      return false;
+    if ( moves ) {
+      auto position = movement->transforms.get(e).position;
+      if ( position.x != value.x || position.y != value.y )
+        return false;
+    }
+
+    auto collides = (live.signature & masks[1]) != 0;
+    if ( collision->boxes.has_component(e) != collides )
+      return false;
+    if ( collides ) {
+      auto box = collision->boxes.get(e);
+      if ( box.left != value.x || box.top != value.y )
+        return false;
+    }
+
+    return true;
+  }
+
+  /// \brief Checks a destroyed handle doesn't resolve to anything, even if
+  /// its id has been reused
+  bool verify_stale(const ecs::Entity& e) const
+  {
+    return !ecs.is_alive(e) && ecs.signature(e) == 0
+      && !movement->transforms.has_component(e)
+      && !collision->boxes.has_component(e);
+  }
+
+  /// \brief Checks every live and recently destroyed handle
+  /// \return Number of handles that failed
+  size_t verify_all()
+  {
+    size_t failures = 0;
+    for ( auto& e : live )
+      failures += !verify(e);
+    for ( auto& e : stale )
+      failures += !verify_stale(e);
+    if ( ecs.size() != live.size() )
+      failures++;
+    return failures;
+  }
+};
+
+/// \brief Runs the churn benchmark for each population, writing a summary
+/// row per population and operation
+/// \return Process exit code, non-zero if any handle resolved wrongly
+int run_churn(const Options& options)
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::ofstream summary(options.summary);
+  summary << "Operation,Population,Count,Ops/s,Mean,P50,P95,P99,Max\n";
+
+  const char* names[] = { "Create", "Destroy", "Attach", "Remove" };
+  size_t failures = 0;
+
+  // Missing rates are zero and extra ones are ignored
+  auto rates = options.rates;
+  rates.resize(churn_ops, 0);
+
+  for ( auto population : options.entities ) {
+    std::mt19937 rng(options.seed);
+    std::discrete_distribution<int> pickOp(rates.begin(), rates.end());
+
+    ChurnWorld world;
+    auto entities = world.ecs.create_many(population);
+    world.ecs.attach<ecs::MovementSystem>(entities);
+    world.ecs.attach<ecs::CollisionSystem>(entities);
+
+    world.live.reserve(population);
+    for ( auto e : entities ) {
+      LiveEntity live { e, world.nextPayload++, world.masks[0] | world.masks[1] };
+      world.write(live, world.masks[0]);
+      world.write(live, world.masks[1]);
+      world.live.push_back(live);
+    }
+
+    std::vector<double> times[churn_ops];
+    for ( auto& t : times )
+      t.reserve(options.churn / churn_ops);
+
+    size_t skipped = 0;
+
+    for ( int i = 0; i < options.churn; ++i ) {
+      auto op = static_cast<ChurnOp>(pickOp(rng));
+      if ( op != churn_create && world.live.empty() )
+        op = churn_create;
+
+      // Choose the target and system outside the timed region. Targets that
+      // already have, or lack, every system are re-picked so the mix of
+      // operations run matches --rates, falling back to a scan from a random
+      // entity once random picks have failed a few times
+      size_t index = 0;
+      uint64_t mask = 0;
+      auto count = world.live.size();
+      auto from = count > 0 ? std::uniform_int_distribution<size_t>(0, count - 1)(rng) : 0;
+      for ( size_t attempt = 0; op != churn_create && attempt < count + 8; ++attempt ) {
+        if ( attempt < 8 )
+          index = std::uniform_int_distribution<size_t>(0, count - 1)(rng);
+        else
+          index = (from + attempt - 8) % count;
+
+        auto side = std::uniform_int_distribution<int>(0, 1)(rng);
+        auto signature = world.live[index].signature;
+
+        if ( op == churn_attach ) {
+          auto missing = (world.masks[0] | world.masks[1]) & ~signature;
+          mask = (missing & world.masks[side]) != 0 ? world.masks[side] : missing;
+        } else if ( op == churn_remove ) {
+          mask = (signature & world.masks[side]) != 0 ? world.masks[side] : signature;
+        } else {
+          break;
+        }
+
+        if ( mask != 0 )
+          break;
+      }
+
+      // No entity can take the operation
+      if ( (op == churn_attach || op == churn_remove) && mask == 0 ) {
+        skipped++;
+        continue;
+      }
+
+      auto& ecs = world.ecs;
+      auto target = world.live.empty() ? ecs::Entity() : world.live[index].entity;
+      ecs::Entity created;
+
+      auto start = Clock::now();
+      switch ( op ) {
+        case churn_create:
+          created = ecs.create();
+          break;
+        case churn_destroy:
+          ecs.destroy(target);
+          break;
+        case churn_attach:
+          if ( mask == world.masks[0] )
+            ecs.attach<ecs::MovementSystem>(target);
+          else
+            ecs.attach<ecs::CollisionSystem>(target);
+          break;
+        default:
+          if ( mask == world.masks[0] )
+            ecs.remove<ecs::MovementSystem>(target);
+          else
+            ecs.remove<ecs::CollisionSystem>(target);
+          break;
+      }
+      times[op].push_back(std::chrono::duration<double>(Clock::now() - start).count());
+
+      // Update the model and check the entity that was touched
+      if ( op == churn_create ) {
+        world.live.push_back(LiveEntity { created, world.nextPayload++, 0 });
+        failures += !world.verify(world.live.back());
+      } else if ( op == churn_destroy ) {
+        world.retire(target);
+        failures += !world.verify_stale(target);
+        world.live[index] = world.live.back();
+        world.live.pop_back();
+      } else {
+        auto& live = world.live[index];
+        if ( op == churn_attach ) {
+          live.signature |= mask;
+          world.write(live, mask);
+        } else {
+          live.signature &= ~mask;
+        }
+        failures += !world.verify(live);
+      }
+    }
+
+    failures += world.verify_all();
+
+    std::cout << "Churn x" << population << ": " << world.live.size()
+              << " alive after " << options.churn << " operations ("
+              << skipped << " skipped)\n";
+
+    // Skipped operations shift the mix, so show what actually ran
+    double totalRate = 0;
+    for ( auto rate : rates )
+      totalRate += rate;
+    auto ran = static_cast<double>(options.churn - skipped);
+
+    std::cout << "  Rates configured / effective:";
+    for ( int op = 0; op < churn_ops; ++op ) {
+      std::cout << " " << names[op] << " " << 100.0 * rates[op] / totalRate
+                << "% / " << (ran > 0 ? 100.0 * times[op].size() / ran : 0.0) << "%";
+    }
+    std::cout << "\n";
+
+    for ( int op = 0; op < churn_ops; ++op ) {
+      if ( times[op].empty() )
+        continue;
+
+      // Throughput counts only time spent inside the operations themselves
+      auto s = summarize(times[op]);
+      auto opsPerSecond = 1.0 / s.mean;
+      summary << names[op] << "," << population << "," << times[op].size() << ","
+              << opsPerSecond << "," << s.mean << "," << s.p50 << "," << s.p95
+              << "," << s.p99 << "," << s.max << "\n";
+
+      std::cout << "  " << names[op] << ": " << opsPerSecond << " ops/s, p50 "
+                << s.p50 * 1e9 << " ns, p99 " << s.p99 * 1e9 << " ns, max "
+                << s.max * 1e9 << " ns\n";
+    }
+  }
+
+  if ( failures > 0 ) {
+    std::cerr << failures << " handle checks failed\n";
+    return 1;
+  }
+
+  std::cout << "Every handle resolved to the right entity\n";
+  return 0;
+}
+
+/// \brief Runs the sprite batching benchmark for each population, writing a
+/// summary row per population and layout
+/// \return Process exit code, non-zero if a batch lost or gained sprites
+int run_batch(const Options& options)
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::ofstream summary(options.summary);
+  summary << "Layout,Sprites,Textures,Batches,Mean,P50,P95,P99,Max\n";
+
+  std::vector<sf::Texture> textures(options.batch);
+  size_t failures = 0;
+
+  for ( auto population : options.entities ) {
+    ecs::EntityMap ecs;
+    auto render = ecs.add_system<ecs::SpriteSystem>();
+
+    auto entities = ecs.create_many(population);
+    ecs.attach<ecs::SpriteSystem>(entities);
+
+    // Neighbouring sprites never share a texture, the worst case for finding
+    // each sprites batch
+    for ( int i = 0; i < population; ++i ) {
+      auto sprite = render->spriteData.get(entities[i]);
+      sprite->setTexture(textures[i % options.batch]);
+      sprite->setPosition(i, i);
+    }
+
+    ecs::SpriteFrame frame;
+    const char* layouts[] = { "Interleaved", "Sorted" };
+
+    for ( int layout = 0; layout < 2; ++layout ) {
+      if ( layout == 1 ) {
+        while ( !render->sort_by_texture(static_cast<size_t>(population)) ) {}
+      }
+
+      for ( int w = 0; w < options.warmup; ++w )
+        render->prepare(frame);
+
+      std::vector<double> times;
+      times.reserve(options.samples * options.frames);
+
+      for ( int f = 0; f < options.samples * options.frames; ++f ) {
+        auto start = Clock::now();
+        render->prepare(frame);
+        times.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+      }
+
+      // Every sprite should land in exactly one quad of a non-empty batch
+      size_t batches = 0;
+      size_t vertices = 0;
+      for ( auto& batch : frame.batches ) {
+        batches += batch.vertices.getVertexCount() > 0;
+        vertices += batch.vertices.getVertexCount();
+      }
+      if ( vertices != static_cast<size_t>(population) * 4 )
+        failures++;
+
+      if ( times.empty() )
+        continue;
+
+      auto s = summarize(times);
+      summary << layouts[layout] << "," << population << "," << options.batch << ","
+              << batches << "," << s.mean << "," << s.p50 << "," << s.p95 << ","
+              << s.p99 << "," << s.max << "\n";
+
+      std::cout << "Batch " << layouts[layout] << " x" << population << " ("
+                << batches << " batches): mean " << s.mean * 1000 << " ms, p99 "
+                << s.p99 * 1000 << " ms\n";
+    }
+  }
+
+  if ( failures > 0 ) {
+    std::cerr << failures << " batch builds dropped or duplicated sprites\n";
+    return 1;
+  }
+
+  return 0;
+}
+
+/// \brief Counts failed expectations in a check, printing the first few
+struct CheckResult {
+  size_t failures = 0;
+
+  /// \brief Records an expectation
+  /// \param ok Whether the expectation held
+  /// \param what Description printed if it didn't
+  void expect(bool ok, const char* what)
+  {
+    if ( ok )
+      return;
+    if ( failures < 5 )
+      std::cerr << "    failed: " << what << "\n";
+    failures++;
+  }
+};
+
+/// \brief Sparse set pages resolve ids on either side of page boundaries,
+/// erasing keeps the rest resolvable, and stale generations never resolve
+void check_sparse_set(const Options&, CheckResult& result)
+{
+  auto page = ecs::SparseSet::page_size;
+  ecs::EntityId ids[] = { 0, 1, page - 1, page, page + 1, 5 * page + 3, 1 << 20 };
+
+  ecs::SparseSet set;
+  for ( auto id : ids )
+    set.insert(ecs::Entity { id, 0 });
+
+  for ( auto id : ids ) {
+    auto index = set.index_of(ecs::Entity { id, 0 });
+    result.expect(index < set.size() && set.entities()[index].id == id,
+                  "inserted id resolves to its dense slot");
+    result.expect(!set.contains(ecs::Entity { id, 1 }), "other generation doesn't resolve");
+  }
+  result.expect(!set.contains(ecs::Entity { 2, 0 }), "id never inserted doesn't resolve");
+  result.expect(!set.contains(ecs::Entity { 3 * page, 0 }), "id in unallocated page doesn't resolve");
+
+  set.erase(ecs::Entity { ids[1], 0 });
+  set.erase(ecs::Entity { ids[3], 0 });
+  for ( size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i ) {
+    auto erased = i == 1 || i == 3;
+    result.expect(set.contains(ecs::Entity { ids[i], 0 }) != erased,
+                  "only erased ids stop resolving");
+  }
+
+  // Reused ids come back with a new generation, so old handles stay dead
+  ecs::EntityMap world;
+  auto movement = world.add_system<ecs::MovementSystem>();
+  auto entities = world.create_many(3);
+  world.attach<ecs::MovementSystem>(entities);
+  world.destroy(entities[1]);
+
+  auto reused = world.create();
+  world.attach<ecs::MovementSystem>(reused);
+  result.expect(reused.id == entities[1].id, "destroyed id is reused");
+  result.expect(reused.generation != entities[1].generation, "reused id has a new generation");
+  result.expect(!world.is_alive(entities[1]) && world.is_alive(reused), "only the new handle is alive");
+  result.expect(!movement->transforms.has_component(entities[1]), "stale handle has no component");
+  result.expect(movement->transforms.has_component(reused), "reused handle has its component");
+  result.expect(world.signature(entities[1]) == 0, "stale handle has no signature");
+}
+
+/// \brief Command buffers play back by the task that recorded them in the
+/// order tasks were added, whichever threads ran them, placeholders resolve
+/// to the entities they create, and commands for destroyed entities are
+/// skipped
+void check_commands(const Options&, CheckResult& result)
+{
+  ecs::JobPool pool(2);
+
+  for ( int run = 0; run < 20; ++run ) {
+    ecs::EntityMap world;
+    auto movement = world.add_system<ecs::MovementSystem>();
+    auto e = world.create();
+    world.attach<ecs::MovementSystem>(e);
+
+    ecs::Transform moved;
+    moved.position = sf::Vector2f(5, 5);
+    movement->transforms.set(e, moved);
+
+    auto doomed = world.create();
+
+    // The first task records from a worker and finishes last, so playing
+    // back in the order buffers were made would attach before removing
+    ecs::Scheduler scheduler(pool);
+    ecs::Access first, second;
+    first.reads = 1;
+    second.reads = 2;
+    scheduler.add("Remove", first, [&] {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      ecs::JobCounter counter;
+      pool.submit([&] { world.commands().remove<ecs::MovementSystem>(e); }, &counter);
+      pool.wait(counter);
+    });
+    scheduler.add("Attach", second, [&] {
+      auto& commands = world.commands();
+      commands.attach<ecs::MovementSystem>(e);
+      auto placeholder = commands.create();
+      commands.attach<ecs::MovementSystem>(placeholder);
+    });
+    scheduler.run();
+
+    world.commands().destroy(doomed);
+    world.commands().attach<ecs::MovementSystem>(doomed);
+    world.flush();
+
+    result.expect(movement->transforms.has_component(e), "remove then attach keeps the entity attached");
+    result.expect(movement->transforms.get(e).position.x == 0, "remove then attach resets the component");
+    result.expect(!world.is_alive(doomed) && !movement->transforms.has_component(doomed),
+                  "commands after a destroy are skipped");
+
+    // The placeholder's entity is the only other one attached
+    size_t created = 0;
+    for ( auto& entity : movement->transforms.entities() )
+      created += entity.id != e.id && world.is_alive(entity);
+    result.expect(created == 1 && movement->transforms.size() == 2,
+                  "placeholder resolves to the created entity");
+  }
+}
+
+/// \brief Sorting a few swaps at a time converges, and switching key midway
+/// restarts rather than leaving a mix of both orders
+void check_sort_step(const Options& options, CheckResult& result)
+{
+  struct Item { int a, b; };
+  auto byA = [](const Item& item) { return item.a; };
+  auto byB = [](const Item& item) { return item.b; };
+
+  std::mt19937 rng(options.seed);
+  ecs::ComponentData<Item> items;
+  std::vector<ecs::Entity> entities;
+  for ( ecs::EntityId i = 0; i < 1000; ++i ) {
+    entities.push_back(ecs::Entity { i, 0 });
+    auto item = items.attach(entities.back());
+    item->a = static_cast<int>(rng() % 100);
+  }
+
+  // Unique keys in a scrambled order
+  for ( auto& item : items.instances )
+    item.b = static_cast<int>(&item - items.instances.data()) * 7919 % 1000;
+
+  auto sorted = [&](int Item::* key) {
+    for ( size_t i = 1; i < items.instances.size(); ++i ) {
+      if ( items.instances[i - 1].*key > items.instances[i].*key )
+        return false;
+    }
+    return true;
+  };
+
+  // Remember what each entity holds to check lookups follow the moves
+  std::vector<int> held;
+  for ( auto& e : entities )
+    held.push_back(items.read(e)->b);
+
+  size_t steps = 0;
+  while ( !items.sort_step(byA, 100) && steps < 100000 )
+    steps++;
+  result.expect(sorted(&Item::a), "sort_step converges");
+
+  items.sort_step(byA, 5);
+  steps = 0;
+  while ( !items.sort_step(byB, 50) && steps < 100000 )
+    steps++;
+  result.expect(sorted(&Item::b), "sort_step converges after switching key");
+  result.expect(items.sort_step(byB, 0), "sorted data stays sorted");
+
+  for ( size_t i = 0; i < entities.size(); ++i )
+    result.expect(items.read(entities[i])->b == held[i], "lookups follow sorted instances");
+}
+
+/// \brief Rewinding the snapshot ring restores each earlier frame exactly,
+/// across creates and destroys, and clamps to the frames it holds
+void check_snapshot_ring(const Options&, CheckResult& result)
+{
+  ecs::EntityMap world;
+  auto movement = world.add_system<ecs::MovementSystem>();
+  world.add_system<ecs::CollisionSystem>();
+
+  auto handles = world.create_many(1000);
+  world.attach<ecs::MovementSystem>(handles);
+  world.attach<ecs::CollisionSystem>(handles);
+
+  // Position of every handle ever made, or -1 if it isn't alive
+  auto state = [&] {
+    std::vector<float> xs;
+    for ( auto& e : handles )
+      xs.push_back(world.is_alive(e) ? movement->transforms.get(e).position.x : -1);
+    return xs;
+  };
+
+  ecs::SnapshotRing ring(4);
+  std::vector<std::vector<float>> expected;
+
+  for ( int frame = 0; frame < 10; ++frame ) {
+    for ( size_t i = 0; i < handles.size(); ++i ) {
+      if ( !world.is_alive(handles[i]) )
+        continue;
+      ecs::Transform transform;
+      transform.position = sf::Vector2f(frame * 1000.0f + i, 0);
+      movement->transforms.set(handles[i], transform);
+    }
+
+    world.destroy(handles[frame * 37 % handles.size()]);
+    handles.push_back(world.create());
+    world.attach<ecs::MovementSystem>(handles.back());
+
+    ring.push(world);
+    expected.push_back(state());
+  }
+
+  // Handles made after a frame are dead when it's restored
+  auto matches = [&](size_t frame) {
+    auto want = expected[frame];
+    want.resize(handles.size(), -1);
+    return state() == want;
+  };
+
+  world.load(ring.latest());
+  result.expect(matches(9), "latest frame restores");
+  result.expect(ring.size() == ring.capacity(), "full ring holds its capacity");
+
+  world.load(ring.rewind(1));
+  result.expect(matches(8), "rewinding one frame restores it");
+  world.load(ring.rewind(2));
+  result.expect(matches(6), "rewinding two frames restores them");
+  world.load(ring.rewind(5));
+  result.expect(matches(5), "rewinding clamps to the oldest frame");
+  result.expect(ring.size() == 0, "rewinding everything empties the ring");
+}
+
+/// \brief The broad-phase grid reports exactly the overlapping pairs a brute
+/// force search finds, including stacked, huge and far away boxes
+void check_broad_phase(const Options& options, CheckResult& result)
+{
+  ecs::EntityMap world;
+  auto collision = world.add_system<ecs::CollisionSystem>();
+  auto entities = world.create_many(300);
+  world.attach<ecs::CollisionSystem>(entities);
+
+  auto compare = [&](const char* layout) {
+    auto& boxes = collision->boxes;
+    std::vector<ecs::CollisionPair> pairs;
+    collision->grid.build(boxes);
+    collision->grid.find_pairs(boxes, pairs);
+
+    std::set<std::pair<ecs::EntityId, ecs::EntityId>> found;
+    for ( auto& pair : pairs ) {
+      auto ordered = std::make_pair(std::min(pair.a, pair.b), std::max(pair.a, pair.b));
+      result.expect(pair.a != pair.b && found.insert(ordered).second, layout);
+    }
+
+    size_t overlaps = 0;
+    for ( size_t i = 0; i < boxes.size(); ++i ) {
+      for ( size_t j = i + 1; j < boxes.size(); ++j ) {
+        if ( boxes.min_x[i] < boxes.max_x[j] && boxes.min_x[j] < boxes.max_x[i]
+          && boxes.min_y[i] < boxes.max_y[j] && boxes.min_y[j] < boxes.max_y[i] ) {
+          overlaps++;
+          result.expect(found.count(std::make_pair(ecs::EntityId(i), ecs::EntityId(j))) == 1, layout);
+        }
+      }
+    }
+    result.expect(overlaps == found.size(), layout);
+  };
+
+  for ( auto& e : entities )
+    collision->boxes.set(e, sf::FloatRect(10, 10, 5, 5));
+  compare("stacked boxes all pair up");
+
+  std::mt19937 rng(options.seed);
+  std::uniform_real_distribution<float> position(-2000, 2000), size(1, 100);
+  for ( auto& e : entities )
+    collision->boxes.set(e, sf::FloatRect(position(rng), position(rng), size(rng), size(rng)));
+  collision->boxes.set(entities[5], sf::FloatRect(-1e30f, -1e30f, 2e30f, 2e30f));
+  collision->boxes.set(entities[6], sf::FloatRect(-3000, -3000, 6000, 6000));
+  collision->boxes.set(entities[7], sf::FloatRect(1e20f, 1e20f, 10, 10));
+  collision->boxes.set(entities[8], sf::FloatRect(1e20f, 1e20f, 10, 10));
+  compare("random, oversized and far boxes match brute force");
+}
+
+/// \brief Hierarchy world positions match walking each entity's parent chain,
+/// across destroys that orphan subtrees
+void check_hierarchy(const Options& options, CheckResult& result)
+{
+  ecs::EntityMap world;
+  auto hierarchy = world.add_system<ecs::HierarchySystem>();
+  auto entities = world.create_many(2000);
+  world.attach<ecs::HierarchySystem>(entities);
+
+  std::mt19937 rng(options.seed);
+  for ( size_t i = 0; i < entities.size(); ++i ) {
+    hierarchy->set_local(entities[i], sf::Vector2f(rng() % 10, rng() % 10),
+                         sf::Vector2f(1 + (rng() % 3) * 0.5f, 1));
+    if ( i > 0 && rng() % 4 != 0 )
+      hierarchy->set_parent(entities[i], entities[rng() % i]);
+  }
+
+  for ( int round = 0; round < 3; ++round ) {
+    world.update();
+
+    for ( auto& e : entities ) {
+      if ( !world.is_alive(e) )
+        continue;
+
+      std::vector<ecs::Entity> chain;
+      for ( auto link = e; hierarchy->nodes.read(link) != nullptr && chain.size() <= entities.size(); ) {
+        chain.push_back(link);
+        link = hierarchy->nodes.read(link)->parent;
+      }
+
+      sf::Vector2f expected, scale(1, 1);
+      for ( auto link = chain.rbegin(); link != chain.rend(); ++link ) {
+        auto node = hierarchy->nodes.read(*link);
+        expected.x += node->position.x * scale.x;
+        expected.y += node->position.y * scale.y;
+        scale.x *= node->scale.x;
+        scale.y *= node->scale.y;
+      }
+
+      auto actual = hierarchy->world_position(e);
+      result.expect(std::fabs(actual.x - expected.x) <= 1e-4f * std::fabs(expected.x) + 1e-3f
+                    && std::fabs(actual.y - expected.y) <= 1e-4f * std::fabs(expected.y) + 1e-3f,
+                    "world position matches the parent chain");
+    }
+
+    for ( int i = 0; i < 100; ++i )
+      world.destroy(entities[rng() % entities.size()]);
+  }
+}
+
+/// \brief Runs every behavioural check, printing the result of each
+/// \return Process exit code, non-zero if any check failed
+int run_checks(const Options& options)
+{
+  using Check = void (*)(const Options&, CheckResult&);
+  std::pair<const char*, Check> checks[] = {
+    { "Sparse set and generations", check_sparse_set },
+    { "Command buffer playback", check_commands },
+    { "Incremental sorting", check_sort_step },
+    { "Snapshot ring", check_snapshot_ring },
+    { "Broad-phase pairs", check_broad_phase },
+    { "Hierarchy transforms", check_hierarchy }
+  };
+
+  size_t failed = 0;
+  for ( auto& check : checks ) {
+    CheckResult result;
+    check.second(options, result);
+    failed += result.failures > 0;
+
+    std::cout << check.first << ": ";
+    if ( result.failures == 0 )
+      std::cout << "ok\n";
+    else
+      std::cout << result.failures << " failures\n";
+  }
+
+  if ( failed > 0 ) {
+    std::cerr << failed << " checks failed\n";
+    return 1;
+  }
+
+  return 0;
+}
+
+}
+
+/// \brief Entry point
+int main(int argc, char** argv)
+{
+  auto options = parse_options(argc, argv);
+
+  // Must happen before anything uses the shared pool
+  ecs::JobPool::set_shared_threads(static_cast<unsigned>(options.threads));
+
+  if ( options.churn > 0 )
+    return run_churn(options);
+
+  if ( options.check )
+    return run_checks(options);
+
+  if ( options.batch > 0 )
+    return run_batch(options);
+
+  // Sprites have no texture so nothing touches the GPU, and use an empty
+  // texture for the OO design which requires one
+  sf::Texture texture;
+  sf::FloatRect check(10, 10, 10, 10);
+
+  std::ofstream csv(options.output);
+  csv << "Experiment,Sample,Average Frame Time,Entities,Threads\n";
+
+  std::ofstream summary(options.summary);
+  summary << "Experiment,Entities,Threads,Mean,Stddev,P50,P95,P99,Max\n";
+
+  const char* names[] = { "Benchmark", "OOP", "ECS" };
+
+  for ( auto numEntities : options.entities ) {
+    for ( int experiment = 0; experiment < 3; ++experiment ) {
+      std::vector<double> times;
+      auto threads = (experiment == 2) ? options.threads + 1 : 1;
+
+      if ( experiment == 0 ) {
+        std::vector<sf::Sprite> sprites(numEntities);
+        std::vector<bool> hits(numEntities);
+        for ( int i = 0; i < numEntities; ++i )
+          sprites[i].setPosition(i, i);
+
+        times = run(options, experiment, numEntities, threads, [&] {
+          for ( int i = 0; i < numEntities; ++i )
+            sprites[i].move(1, 1);
+          for ( int i = 0; i < numEntities; ++i )
+            hits[i] = sprites[i].getGlobalBounds().intersects(check);
+        }, csv);
+      } else if ( experiment == 1 ) {
+        std::vector<ecs::Character> objects;
+        objects.reserve(numEntities);
+        for ( int i = 0; i < numEntities; ++i ) {
+          objects.emplace_back(
+            texture, sf::Vector2f(i, i), sf::Vector2f(1, 1), check
+          );
+        }
+
+        times = run(options, experiment, numEntities, threads, [&] {
+          for ( auto& object : objects )
+            object.update();
+          for ( auto& object : objects )
+            object.update_aabb();
+        }, csv);
+      } else {
+        ecs::EntityMap ecs;
+        auto movement = ecs.add_system<ecs::MovementSystem>();
+        auto collision = ecs.add_system<ecs::CollisionSystem>();
+
+        auto entities = ecs.create_many(numEntities);
+        ecs.attach<ecs::MovementSystem>(entities);
+        ecs.attach<ecs::CollisionSystem>(entities);
+
+        for ( int i = 0; i < numEntities; ++i ) {
+          auto e = entities[i];
+
+          ecs::Transform transform;
+          transform.position = sf::Vector2f(i, i);
+          transform.velocity = sf::Vector2f(1, 1);
+          movement->transforms.set(e, transform);
+          collision->boxes.set(e, sf::FloatRect(i, i, 0, 0));
+        }
+
+        // Boxes follow the transforms every frame as the other designs' bounds
+        // do, so change tracking can't skip any of them. The broad-phase is
+        // left out as the other designs have no equivalent
+        times = run(options, experiment, numEntities, threads, [&] {
+          movement->update();
+          collision->sync(movement->transforms);
+          collision->update_collision(check);
+        }, csv);
+      }
+
+      auto s = summarize(times);
+      summary << experiment << "," << numEntities << "," << threads << ","
+              << s.mean << "," << s.stddev << "," << s.p50 << "," << s.p95 << "," << s.p99
+              << "," << s.max << "\n";
+
+      std::cout << names[experiment] << " x" << numEntities
+                << " (" << threads << " threads): mean " << s.mean * 1000 << " ms, stddev "
+                << s.stddev * 1000 << " ms, p99 " << s.p99 * 1000 << " ms\n";
+    }
+  }
+
+  return 0;
+}
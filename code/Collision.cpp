@@ -0,0 +1,287 @@
+//
+// Collision.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "Collision.hpp"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ecs {
+
+void intersect(const float* minX, const float* minY,
+               const float* maxX, const float* maxY,
+               size_t count, const sf::FloatRect& rect, uint64_t* mask)
+{
+  auto left = rect.left;
+  auto top = rect.top;
+  auto right = rect.left + rect.width;
+  auto bottom = rect.top + rect.height;
+
+  for ( size_t word = 0; word < (count + 63) / 64; ++word )
+    mask[word] = 0;
+
+  size_t i = 0;
+
+#if defined(__AVX__)
+  auto l = _mm256_set1_ps(left);
+  auto t = _mm256_set1_ps(top);
+  auto r = _mm256_set1_ps(right);
+  auto b = _mm256_set1_ps(bottom);
+
+  for ( ; i + 8 <= count; i += 8 ) {
+    auto x = _mm256_and_ps(
+      _mm256_cmp_ps(_mm256_loadu_ps(minX + i), r, _CMP_LT_OQ),
+      _mm256_cmp_ps(l, _mm256_loadu_ps(maxX + i), _CMP_LT_OQ)
+    );
+    auto y = _mm256_and_ps(
+      _mm256_cmp_ps(_mm256_loadu_ps(minY + i), b, _CMP_LT_OQ),
+      _mm256_cmp_ps(t, _mm256_loadu_ps(maxY + i), _CMP_LT_OQ)
+    );
+    auto bits = static_cast<uint64_t>(_mm256_movemask_ps(_mm256_and_ps(x, y)));
+    mask[i / 64] |= bits << (i % 64);
+  }
+#elif defined(__SSE2__)
+  auto l = _mm_set1_ps(left);
+  auto t = _mm_set1_ps(top);
+  auto r = _mm_set1_ps(right);
+  auto b = _mm_set1_ps(bottom);
+
+  for ( ; i + 4 <= count; i += 4 ) {
+    auto x = _mm_and_ps(
+      _mm_cmplt_ps(_mm_loadu_ps(minX + i), r),
+      _mm_cmplt_ps(l, _mm_loadu_ps(maxX + i))
+    );
+    auto y = _mm_and_ps(
+      _mm_cmplt_ps(_mm_loadu_ps(minY + i), b),
+      _mm_cmplt_ps(t, _mm_loadu_ps(maxY + i))
+    );
+    auto bits = static_cast<uint64_t>(_mm_movemask_ps(_mm_and_ps(x, y)));
+    mask[i / 64] |= bits << (i % 64);
+  }
+#endif
+
+  for ( ; i < count; ++i ) {
+    auto overlap = minX[i] < right && left < maxX[i]
+      && minY[i] < bottom && top < maxY[i];
+    mask[i / 64] |= static_cast<uint64_t>(overlap) << (i % 64);
+  }
+}
+
+void CollisionGrid::build(const BoxData& boxes)
+{
+  auto count = boxes.size();
+
+  // Size the table to about two buckets per box to keep collisions rare
+  uint32_t buckets = 64;
+  while ( buckets < count * 2 )
+    buckets *= 2;
+
+  mask_ = buckets - 1;
+  starts_.assign(buckets + 1, 0);
+  keys_.clear();
+  owners_.clear();
+  oversized_.clear();
+  isOversized_.assign(count, 0);
+
+  for ( size_t i = 0; i < count; ++i ) {
+    auto first = keys_.size();
+    auto x0 = cell(boxes.min_x[i]);
+    auto y0 = cell(boxes.min_y[i]);
+    auto x1 = cell(boxes.max_x[i]);
+    auto y1 = cell(boxes.max_y[i]);
+
+    // Boxes covering too many cells are tested against every box instead
+    auto cells = (int64_t(x1) - x0 + 1) * (int64_t(y1) - y0 + 1);
+    if ( cells > max_box_cells ) {
+      oversized_.push_back(static_cast<EntityId>(i));
+      isOversized_[i] = 1;
+      continue;
+    }
+
+    for ( auto cy = y0; cy <= y1; ++cy ) {
+      for ( auto cx = x0; cx <= x1; ++cx ) {
+        auto b = bucket(cx, cy);
+
+        // Insert each box into a bucket at most once even if several of its
+        // cells hash to it
+        if ( std::find(keys_.begin() + first, keys_.end(), b) != keys_.end() )
+          continue;
+
+        keys_.push_back(b);
+        owners_.push_back(static_cast<EntityId>(i));
+        starts_[b + 1]++;
+      }
+    }
+  }
+
+  for ( uint32_t b = 0; b < buckets; ++b )
+    starts_[b + 1] += starts_[b];
+
+  entries_.resize(keys_.size());
+  std::vector<uint32_t> cursor(starts_.begin(), starts_.end() - 1);
+  for ( size_t k = 0; k < keys_.size(); ++k )
+    entries_[cursor[keys_[k]]++] = owners_[k];
+}
+
+void CollisionGrid::find_pairs(const BoxData& boxes,
+                               std::vector<CollisionPair>& pairs) const
+{
+  if ( starts_.empty() )
+    return;
+
+  auto overlaps = [&](EntityId ia, EntityId ib) {
+    return boxes.min_x[ia] < boxes.max_x[ib] && boxes.min_x[ib] < boxes.max_x[ia]
+      && boxes.min_y[ia] < boxes.max_y[ib] && boxes.min_y[ib] < boxes.max_y[ia];
+  };
+
+  for ( uint32_t b = 0; b <= mask_; ++b ) {
+    for ( auto j = starts_[b]; j < starts_[b + 1]; ++j ) {
+      auto ia = entries_[j];
+
+      for ( auto k = j + 1; k < starts_[b + 1]; ++k ) {
+        auto ib = entries_[k];
+
+        if ( !overlaps(ia, ib) )
+          continue;
+
+        // Only report the pair from the cell holding its overlaps top-left
+        // corner so pairs sharing several cells are reported once
+        auto x = std::max(boxes.min_x[ia], boxes.min_x[ib]);
+        auto y = std::max(boxes.min_y[ia], boxes.min_y[ib]);
+        if ( bucket(cell(x), cell(y)) != b )
+          continue;
+
+        pairs.push_back(CollisionPair { ia, ib });
+      }
+    }
+  }
+
+  // Oversized boxes are tested against every box, each pair of oversized
+  // boxes from the lower of the two
+  for ( auto ia : oversized_ ) {
+    for ( EntityId ib = 0; ib < isOversized_.size(); ++ib ) {
+      if ( ib == ia || (isOversized_[ib] && ib < ia) || !overlaps(ia, ib) )
+        continue;
+
+      pairs.push_back(CollisionPair { std::min(ia, ib), std::max(ia, ib) });
+    }
+  }
+}
+
+const EntityId* CollisionGrid::bucket_at(float x, float y, size_t& count) const
+{
+  if ( starts_.empty() ) {
+    count = 0;
+    return nullptr;
+  }
+
+  auto b = bucket(cell(x), cell(y));
+  count = starts_[b + 1] - starts_[b];
+  return entries_.data() + starts_[b];
+}
+
+void CollisionSystem::sync(const TransformData& transforms)
+{
+  auto& owners = boxes.entities();
+  auto version = boxes.version();
+
+  for ( size_t i = 0; i < owners.size(); ++i ) {
+    auto t = transforms.index_of(owners[i]);
+    if ( t == SparseSet::null_index )
+      continue;
+
+    auto x = transforms.x[t];
+    auto y = transforms.y[t];
+    if ( x == boxes.min_x[i] && y == boxes.min_y[i] )
+      continue;
+
+    auto width = boxes.max_x[i] - boxes.min_x[i];
+    auto height = boxes.max_y[i] - boxes.min_y[i];
+    boxes.max_x[i] = x + width;
+    boxes.max_y[i] = y + height;
+    boxes.min_x[i] = x;
+    boxes.min_y[i] = y;
+    boxes.versions[i] = version;
+  }
+}
+
+void CollisionSystem::update_collision(const sf::FloatRect &rect)
+{
+  auto count = boxes.size();
+  hits.resize((count + 63) / 64, 0);
+
+  if ( hitsSeen_ == 0 || rect != hitsQuery_ ) {
+    // Split on whole mask words so no two jobs write the same word
+    parallel_for(hits.data(), hits.size(), 256, [&](size_t begin, size_t end) {
+      auto first = begin * 64;
+      auto count = std::min(end * 64, boxes.size()) - first;
+      intersect(boxes.min_x.data() + first, boxes.min_y.data() + first,
+                boxes.max_x.data() + first, boxes.max_y.data() + first,
+                count, rect, hits.data() + begin);
+    });
+  } else {
+    // Boxes moved into a new index by detach are stamped too, so retesting
+    // changed boxes covers every index whose bit could be stale
+    for ( size_t i = 0; i < count; ++i ) {
+      if ( !boxes.changed_since(i, hitsSeen_) )
+        continue;
+
+      uint64_t bit;
+      intersect(&boxes.min_x[i], &boxes.min_y[i], &boxes.max_x[i], &boxes.max_y[i],
+                1, rect, &bit);
+      auto& word = hits[i / 64];
+      word = (word & ~(uint64_t(1) << (i % 64))) | (bit << (i % 64));
+    }
+
+    // Clear bits left past the end by removed boxes
+    if ( count % 64 != 0 )
+      hits.back() &= (uint64_t(1) << (count % 64)) - 1;
+  }
+
+  hitsQuery_ = rect;
+  hitsSeen_ = boxes.mark();
+}
+
+void CollisionSystem::update_pairs()
+{
+  auto count = boxes.size();
+  auto changed = pairsSeen_ == 0 || count != pairsCount_;
+  for ( size_t i = 0; i < count && !changed; ++i )
+    changed = boxes.changed_since(i, pairsSeen_);
+
+  pairsSeen_ = boxes.mark();
+  pairsCount_ = count;
+  if ( !changed )
+    return;
+
+  grid.build(boxes);
+  pairs.clear();
+  grid.find_pairs(boxes, pairs);
+}
+
+void CollisionSystem::collect_hits(std::vector<Entity>& entities) const
+{
+  auto& owners = boxes.entities();
+  for ( size_t word = 0; word < hits.size(); ++word ) {
+    auto bits = hits[word];
+    while ( bits != 0 ) {
+      auto bit = __builtin_ctzll(bits);
+      entities.push_back(owners[word * 64 + bit]);
+      bits &= bits - 1;
+    }
+  }
+}
+
+}
@@ -0,0 +1,561 @@
+//
+// Collision.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_COLLISION_HPP
+#define ECS_FRAMEWORK_COLLISION_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Entity.hpp"
+#include "Transform.hpp"
+
+namespace ecs {
+
+/// \brief Tests a batch of boxes against a rectangle, setting bit i of the
+/// mask if box i intersects it. Uses the same strict overlap test as
+/// sf::Rect::intersects and processes 8 (AVX) or 4 (SSE) boxes per
+/// instruction when the compiler targets them
+/// \param minX Left edge of each box
+/// \param minY Top edge of each box
+/// \param maxX Right edge of each box
+/// \param maxY Bottom edge of each box
+/// \param count Number of boxes
+/// \param rect Rectangle to test against
+/// \param mask Output bitmask with room for count bits, rounded up to whole
+/// words. Every word covering the boxes is overwritten
+void intersect(const float* minX, const float* minY,
+               const float* maxX, const float* maxY,
+               size_t count, const sf::FloatRect& rect, uint64_t* mask);
+
+/// \brief BoxData stores axis-aligned collision boxes as a structure of
+/// arrays of their min and max coordinates
+struct BoxData {
+
+  /// Type of component stored
+  using value_type = sf::FloatRect;
+  /// Pointer-like handle to a box, as returned by EntityMap::get()
+  using pointer = SoaPointer<BoxData>;
+
+  /// Left edge of each box
+  AlignedVector<float> min_x;
+  /// Top edge of each box
+  AlignedVector<float> min_y;
+  /// Right edge of each box
+  AlignedVector<float> max_x;
+  /// Bottom edge of each box
+  AlignedVector<float> max_y;
+  /// Version each box was last written at through set(), scatter(), touch(),
+  /// attach() or by being moved by detach(). Writing the arrays directly
+  /// isn't tracked
+  std::vector<uint32_t> versions;
+
+  /// \brief Gets an entities box
+  /// \param entity The entity whose box is being retrieved
+  /// \return The box, or an empty box if the entity has none
+  inline sf::FloatRect get(const Entity& entity) const
+  {
+    auto index = entities_.index_of(entity);
+    if ( index == SparseSet::null_index )
+      return sf::FloatRect();
+
+    return gather(index);
+  }
+
+  /// \brief Sets an entities box. Does nothing if the entity has none
+  /// \param entity The entity whose box is being set
+  /// \param box The new box
+  inline void set(const Entity& entity, const sf::FloatRect& box)
+  {
+    auto index = entities_.index_of(entity);
+    if ( index == SparseSet::null_index )
+      return;
+
+    scatter(index, box);
+  }
+
+  /// \brief Gets a box by index
+  /// \param index Index of the box
+  /// \return The box
+  inline sf::FloatRect gather(size_t index) const
+  {
+    return sf::FloatRect(min_x[index], min_y[index],
+                         max_x[index] - min_x[index], max_y[index] - min_y[index]);
+  }
+
+  /// \brief Sets a box by index, stamping it as changed
+  /// \param index Index of the box
+  /// \param box The new box
+  inline void scatter(size_t index, const sf::FloatRect& box)
+  {
+    min_x[index] = box.left;
+    min_y[index] = box.top;
+    max_x[index] = box.left + box.width;
+    max_y[index] = box.top + box.height;
+    versions[index] = version_;
+  }
+
+  /// \brief Stamps a box with the current version
+  /// \param index Index of the box
+  inline void touch(size_t index) { versions[index] = version_; }
+
+  /// \brief Gets a handle to a box by index that writes it back when
+  /// destroyed
+  /// \param index Index of the box
+  /// \return Handle to the box
+  inline pointer component_at(size_t index) { return pointer(this, index); }
+
+  /// \brief Splits the box indices into ranges that run in parallel on a job
+  /// pool, starting on a cache line of the coordinate arrays and versions
+  /// \param fn Function called as fn(begin, end) for each range
+  /// \param grain Target number of boxes per job
+  /// \param pool Pool to run jobs on
+  template <typename Fn>
+  void parallel_ranges(Fn&& fn, size_t grain = 4096, JobPool& pool = JobPool::shared())
+  {
+    ecs::parallel_for(min_x.data(), versions.data(), size(), grain, fn, pool);
+  }
+
+  /// \brief Gets the version writes are currently stamped with
+  /// \return The current version
+  inline uint32_t version() const { return version_; }
+
+  /// \brief Ends the current version so later writes can be told apart from
+  /// earlier ones. Readers keep the returned value and pass it to
+  /// changed_since() next time
+  /// \return The version that was current, every box written so far has a
+  /// version no greater than it
+  inline uint32_t mark() { return version_++; }
+
+  /// \brief Checks if a box was written after a mark
+  /// \param index Index of the box
+  /// \param since Value returned by an earlier mark(), or 0 for all boxes
+  /// \return True if the box changed since then
+  inline bool changed_since(size_t index, uint32_t since) const
+  {
+    return versions[index] > since;
+  }
+
+  /// \brief Checks to see if the entity has a box
+  /// \param entity To check for
+  /// \return True if found, false otherwise
+  inline bool has_component(const Entity& entity) const
+  {
+    return entities_.contains(entity);
+  }
+
+  /// \brief Attaches an empty box to an entity
+  /// \param entity Entity to attach
+  inline void attach(const Entity& entity)
+  {
+    min_x.push_back(0);
+    min_y.push_back(0);
+    max_x.push_back(0);
+    max_y.push_back(0);
+    versions.push_back(version_);
+    entities_.insert(entity);
+  }
+
+  /// \brief Attaches a zeroed box to each of a range of entities,
+  /// growing each array once
+  /// \param entities First entity to attach
+  /// \param count Number of entities to attach
+  inline void attach(const Entity* entities, size_t count)
+  {
+    auto first = min_x.size();
+    min_x.resize(first + count, 0);
+    min_y.resize(first + count, 0);
+    max_x.resize(first + count, 0);
+    max_y.resize(first + count, 0);
+    versions.resize(first + count, version_);
+    entities_.insert(entities, count);
+  }
+
+  /// \brief Reserves room in every array so attaching up to capacity doesn't
+  /// reallocate
+  /// \param capacity Number of boxes to reserve room for
+  inline void reserve(size_t capacity)
+  {
+    min_x.reserve(capacity);
+    min_y.reserve(capacity);
+    max_x.reserve(capacity);
+    max_y.reserve(capacity);
+    versions.reserve(capacity);
+    entities_.reserve(capacity);
+  }
+
+  /// \brief Removes an entities box by moving the last box into its place,
+  /// which counts as a change to the moved box. Does nothing if the entity
+  /// has no box
+  /// \param entity Entity to remove
+  inline void detach(const Entity& entity)
+  {
+    auto index = entities_.erase(entity);
+    if ( index == SparseSet::null_index )
+      return;
+
+    min_x[index] = min_x.back();
+    min_y[index] = min_y.back();
+    max_x[index] = max_x.back();
+    max_y[index] = max_y.back();
+    versions[index] = version_;
+    min_x.pop_back();
+    min_y.pop_back();
+    max_x.pop_back();
+    max_y.pop_back();
+    versions.pop_back();
+  }
+
+  /// \brief Gets the memory held by the arrays
+  /// \return The containers stats
+  MemoryStats memory() const
+  {
+    MemoryStats stats;
+    stats.count = size();
+    stats.capacity = min_x.capacity();
+    stats.dense_bytes = (min_x.capacity() + min_y.capacity() + max_x.capacity() + max_y.capacity()) * sizeof(float);
+    stats.index_bytes = versions.capacity() * sizeof(uint32_t);
+    stats.slack_bytes = ((min_x.capacity() - min_x.size()) + (min_y.capacity() - min_y.size()) + (max_x.capacity() - max_x.size()) + (max_y.capacity() - max_y.size())) * sizeof(float) + (versions.capacity() - versions.size()) * sizeof(uint32_t);
+    entities_.memory(stats);
+    return stats;
+  }
+
+  /// \brief Frees unused capacity and empty sparse pages
+  void shrink_to_fit()
+  {
+    min_x.shrink_to_fit();
+    min_y.shrink_to_fit();
+    max_x.shrink_to_fit();
+    max_y.shrink_to_fit();
+    versions.shrink_to_fit();
+    entities_.shrink_to_fit();
+  }
+
+  /// \brief Writes every array and the entity owning each box
+  /// \param writer Snapshot to write to
+  void save(SnapshotWriter& writer) const
+  {
+    writer.write_array(min_x);
+    writer.write_array(min_y);
+    writer.write_array(max_x);
+    writer.write_array(max_y);
+    entities_.save(writer);
+  }
+
+  /// \brief Replaces every box with those from save(). Versions aren't
+  /// rewound, instead every loaded box counts as changed
+  /// \param reader Snapshot to read from
+  void load(SnapshotReader& reader)
+  {
+    reader.read_array(min_x);
+    reader.read_array(min_y);
+    reader.read_array(max_x);
+    reader.read_array(max_y);
+    entities_.load(reader);
+    versions.assign(min_x.size(), version_);
+  }
+
+  /// \brief Gets the entities owning each box, in array order
+  /// \return The dense entity array
+  inline const std::vector<Entity>& entities() const
+  {
+    return entities_.entities();
+  }
+
+  /// \brief Gets the array index of an entities box
+  /// \param entity Entity to look up
+  /// \return The index if found, SparseSet::null_index otherwise
+  inline EntityId index_of(const Entity& entity) const
+  {
+    return entities_.index_of(entity);
+  }
+
+  /// \brief Gets the number of boxes stored
+  /// \return Number of boxes
+  inline size_t size() const { return min_x.size(); }
+
+private:
+  /// \brief Sparse set used to index into the arrays
+  SparseSet entities_;
+  /// \brief Version stamped on writes
+  uint32_t version_ = 1;
+};
+
+/// \brief CollisionPair is two boxes whose bounds overlap, given as indices
+/// into BoxData with a < b
+struct CollisionPair {
+  EntityId a;
+  EntityId b;
+};
+
+/// \brief CollisionGrid is a broad-phase spatial hash over a uniform grid.
+/// Each build() counting sorts every box into the hashed grid cells it
+/// overlaps, leaving each cells boxes contiguous in memory, so rebuilding
+/// every frame stays linear when most boxes move. Cell size should be around
+/// the size of a typical box. Every bucket is searched however full it is, so
+/// crowded layouts cost more but never lose pairs. Cell coordinates are
+/// clamped to +/- max_cell, and boxes covering more than max_box_cells cells
+/// aren't inserted at all but kept in a separate list tested against every
+/// box, so huge or far away boxes can't blow up the insertion loop
+class CollisionGrid {
+public:
+  /// Largest cell coordinate in either direction, further cells are clamped
+  static constexpr int32_t max_cell = 1 << 20;
+  /// Most cells a box can cover before it's tested by brute force instead
+  static constexpr int64_t max_box_cells = 64;
+
+  /// \brief Initializes an empty grid
+  /// \param cellSize Width and height of each grid cell
+  explicit CollisionGrid(float cellSize = 64.0f)
+    : cellSize_(cellSize), mask_(0) {}
+
+  /// \brief Rebuilds the grid from scratch
+  /// \param boxes Boxes to insert
+  void build(const BoxData& boxes);
+
+  /// \brief Finds every pair of overlapping boxes from the last build. Each
+  /// pair of inserted boxes is reported once, from the cell containing the
+  /// top-left corner of the pairs overlap, and pairs with an oversized box
+  /// are reported once from the oversized list
+  /// \param boxes The boxes the grid was built from
+  /// \param pairs Vector to append the overlapping pairs to
+  void find_pairs(const BoxData& boxes, std::vector<CollisionPair>& pairs) const;
+
+  /// \brief Gets the boxes inserted into the bucket containing a point.
+  /// Oversized boxes aren't in any bucket
+  /// \param x World x coordinate
+  /// \param y World y coordinate
+  /// \param count Set to the number of boxes in the bucket
+  /// \return Pointer to the first box index in the bucket
+  const EntityId* bucket_at(float x, float y, size_t& count) const;
+
+  /// \brief Gets the width and height of each cell
+  /// \return The cell size
+  inline float cell_size() const { return cellSize_; }
+
+  /// \brief Gets the number of boxes too large to insert into the grid,
+  /// which find_pairs() tests against every box
+  /// \return Oversized boxes in the last build
+  inline size_t oversized() const { return oversized_.size(); }
+
+private:
+  /// \brief Width and height of each cell
+  float cellSize_;
+  /// \brief Boxes covering more than max_box_cells cells, in index order
+  std::vector<EntityId> oversized_;
+  /// \brief Non-zero for each box in oversized_, indexed by box
+  std::vector<uint8_t> isOversized_;
+  /// \brief Bucket count minus one, used to wrap cell hashes
+  uint32_t mask_;
+  /// \brief Start of each buckets entries, with a final end offset
+  std::vector<uint32_t> starts_;
+  /// \brief Box indices sorted by bucket
+  std::vector<EntityId> entries_;
+  /// \brief Bucket of each (bucket, box) insertion, in insertion order
+  std::vector<uint32_t> keys_;
+  /// \brief Box index of each insertion, in insertion order
+  std::vector<EntityId> owners_;
+
+  /// \brief Gets the grid cell coordinate containing a world coordinate,
+  /// clamped to +/- max_cell. NaN maps to -max_cell
+  inline int32_t cell(float v) const
+  {
+    auto c = std::floor(v / cellSize_);
+    if ( !(c > -max_cell) )
+      return -max_cell;
+    if ( c > max_cell )
+      return max_cell;
+    return static_cast<int32_t>(c);
+  }
+
+  /// \brief Hashes a cell into a bucket
+  inline uint32_t bucket(int32_t cx, int32_t cy) const
+  {
+    return ((static_cast<uint32_t>(cx) * 73856093u)
+      ^ (static_cast<uint32_t>(cy) * 19349663u)) & mask_;
+  }
+};
+
+/// \brief CollisionSystem tests every collision box against a query rectangle
+/// each frame, producing a bitmask of the boxes that hit it, and finds every
+/// pair of overlapping boxes through a CollisionGrid broad-phase. Only boxes
+/// changed since the last update are retested, and the broad-phase is skipped
+/// entirely when nothing changed
+struct CollisionSystem : public System {
+
+  /// Type of component this system operates on
+  using component_type = sf::FloatRect;
+
+  /// Storage the boxes are kept in
+  using storage_type = BoxData;
+
+  /// The collision boxes to operate on
+  BoxData boxes;
+
+  /// The rectangle tested against each box by update()
+  sf::FloatRect query;
+
+  /// Bit i is set if box i in boxes hit the query on the last update. Valid
+  /// until boxes are next added or removed
+  std::vector<uint64_t> hits;
+
+  /// Broad-phase rebuilt from boxes on each update
+  CollisionGrid grid;
+
+  /// Every pair of overlapping boxes found on the last update, as indices
+  /// into boxes. Valid until boxes are next added or removed
+  std::vector<CollisionPair> pairs;
+
+  /// Transforms the boxes follow, if set. Each update() first moves every
+  /// box to its entities position, keeping its size
+  const TransformData* follow = nullptr;
+
+  /// \brief Adds a new entity to this systems component data.
+  /// \param entity Entity to add
+  inline void add(const Entity& entity) override
+  {
+    boxes.attach(entity);
+  }
+
+  /// \brief Gets the collision boxes, so the system can be used with
+  /// EntityMap::get() and views like one storing ComponentData
+  /// \return The boxes
+  inline BoxData& components() { return boxes; }
+
+  /// \brief Adds a range of entities to this systems component data.
+  /// \param entities First entity to add
+  /// \param count Number of entities to add
+  inline void add_many(const Entity* entities, size_t count) override
+  {
+    boxes.attach(entities, count);
+  }
+
+  /// \brief Removes an entity from this systems component data.
+  /// \param entity Entity to remove
+  inline void remove(const Entity& entity) override
+  {
+    boxes.detach(entity);
+  }
+
+  /// \brief Checks if this system contains a specified entity
+  /// \param entity Entity to check for
+  /// \return True if has entity, false otherwise
+  inline bool has_entity(const Entity& entity) override
+  {
+    return boxes.has_component(entity);
+  }
+
+  /// \brief Declares read access to collision boxes and write access to the
+  /// hit mask and pairs, which consumers declare as a resource read of
+  /// CollisionSystem
+  /// \param access Access to add to
+  inline void declare_access(Access& access) override
+  {
+    access.reads |= component_mask<sf::FloatRect>() | component_mask<Transform>();
+    access.resource_writes |= resource_mask<CollisionSystem>();
+  }
+
+  /// \brief Gets the memory held by the boxes, counting the hit mask and
+  /// pairs as index storage
+  /// \return The collision data stats
+  inline MemoryStats memory() const override
+  {
+    auto stats = boxes.memory();
+    stats.index_bytes += hits.capacity() * sizeof(uint64_t)
+      + pairs.capacity() * sizeof(CollisionPair);
+    stats.slack_bytes += (hits.capacity() - hits.size()) * sizeof(uint64_t)
+      + (pairs.capacity() - pairs.size()) * sizeof(CollisionPair);
+    return stats;
+  }
+
+  /// \brief Frees unused capacity in the boxes, hit mask and pairs
+  inline void shrink_to_fit() override
+  {
+    boxes.shrink_to_fit();
+    hits.shrink_to_fit();
+    pairs.shrink_to_fit();
+  }
+
+  /// \brief Writes the boxes to a snapshot. Hits and pairs are recomputed
+  /// \param writer Snapshot to write to
+  inline void save(SnapshotWriter& writer) const override { boxes.save(writer); }
+
+  /// \brief Checks if save() writes the systems components
+  /// \return Always true
+  inline bool saves_components() const override { return true; }
+
+  /// \brief Restores the boxes from a snapshot, making the next update test
+  /// every box
+  /// \param reader Snapshot to read from
+  inline void load(SnapshotReader& reader) override
+  {
+    boxes.load(reader);
+    hitsSeen_ = 0;
+    pairsSeen_ = 0;
+  }
+
+  /// \brief Moves the boxes to the transforms they follow, then tests each
+  /// box against query and finds overlapping pairs
+  inline void update() override
+  {
+    if ( follow != nullptr )
+      sync(*follow);
+    update_collision(query);
+    update_pairs();
+  }
+
+  /// \brief Moves each box to its entities position, keeping its size. Only
+  /// boxes that move are stamped as changed
+  /// \param transforms Transforms to move the boxes to
+  void sync(const TransformData& transforms);
+
+  /// \brief Tests each box against a rectangle, storing the results in hits.
+  /// If the rectangle is the same as last time only changed boxes are tested
+  /// \param rect Rectangle to test against
+  void update_collision(const sf::FloatRect &rect);
+
+  /// \brief Rebuilds the broad-phase and stores every overlapping pair, unless
+  /// no box has changed since the last rebuild
+  void update_pairs();
+
+  /// \brief Checks if an entities box hit the query on the last update
+  /// \param entity Entity to check
+  /// \return True if the entity has a box that hit, false otherwise
+  inline bool hit(const Entity& entity) const
+  {
+    auto index = boxes.index_of(entity);
+    if ( index == SparseSet::null_index || index / 64 >= hits.size() )
+      return false;
+
+    return (hits[index / 64] >> (index % 64)) & 1;
+  }
+
+  /// \brief Gathers the entities whose boxes hit on the last update
+  /// \param entities Vector to append the entities to
+  void collect_hits(std::vector<Entity>& entities) const;
+
+private:
+  /// \brief Box version seen by the last update_collision()
+  uint32_t hitsSeen_ = 0;
+  /// \brief Rectangle tested by the last update_collision()
+  sf::FloatRect hitsQuery_;
+  /// \brief Box version seen by the last update_pairs()
+  uint32_t pairsSeen_ = 0;
+  /// \brief Number of boxes when pairs was last rebuilt
+  size_t pairsCount_ = 0;
+};
+
+}
+
+#endif //ECS_FRAMEWORK_COLLISION_HPP
@@ -0,0 +1,43 @@
+//
+// DoubleBuffer.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_DOUBLEBUFFER_HPP
+#define ECS_FRAMEWORK_DOUBLEBUFFER_HPP
+
+namespace ecs {
+
+/// \brief DoubleBuffer holds two copies of some state so one stage of a
+/// pipeline can write frame N + 1 while another reads the finished frame N.
+/// Neither side locks, instead swap() is called at a single sync point once
+/// both stages have finished with their buffer
+/// \tparam T Type of state to buffer
+template <typename T>
+class DoubleBuffer {
+public:
+  /// \brief Gets the buffer being written this frame
+  /// \return The write buffer
+  inline T& write() { return buffers_[1 - read_]; }
+
+  /// \brief Gets the buffer finished last frame
+  /// \return The read buffer
+  inline const T& read() const { return buffers_[read_]; }
+
+  /// \brief Publishes the write buffer for reading and recycles the read
+  /// buffer for writing. Must only be called while neither is in use
+  inline void swap() { read_ = 1 - read_; }
+
+private:
+  T buffers_[2];
+  int read_ = 0;
+};
+
+}
+
+#endif //ECS_FRAMEWORK_DOUBLEBUFFER_HPP
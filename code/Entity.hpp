@@ -11,41 +11,334 @@
 #ifndef ECS_FRAMEWORK_COMPONENTDATA_HPP
 #define ECS_FRAMEWORK_COMPONENTDATA_HPP
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
-#include <typeindex>
+#include <typeinfo>
 #include <unordered_map>
 
-#include <SFML/Graphics.hpp>
+#include "Allocator.hpp"
+#include "Scheduler.hpp"
+#include "Snapshot.hpp"
+
+/// \brief Integer type used for entity ids, generations and dense indices.
+/// Define before including this header to change the handle width
+#ifndef ECS_ENTITY_ID_TYPE
+#define ECS_ENTITY_ID_TYPE uint32_t
+#endif
 
 namespace ecs {
 
-/// \brief Entity is an id and index pair that map this instance
-/// to a series of systems and components, tying them all together
+/// \brief Integer type of each Entity field
+using EntityId = ECS_ENTITY_ID_TYPE;
+
+/// \brief Entity is an id and generation pair that map this instance
+/// to a series of systems and components, tying them all together. The id is
+/// a recycled slot in the owning EntityMap and the generation is bumped each
+/// time that slot is destroyed, so stale handles never alias a live entity
 struct Entity {
-  uint16_t id;
-  uint16_t index;
-  uint16_t generation;
+  EntityId id;
+  EntityId generation;
+};
+
+/// \brief MemoryStats describes the memory held by a component container
+struct MemoryStats {
+  /// Number of live components
+  size_t count = 0;
+  /// Number of components that fit before the dense storage grows
+  size_t capacity = 0;
+  /// Bytes allocated for component data, including unused capacity
+  size_t dense_bytes = 0;
+  /// Bytes allocated for the sparse pages mapping ids to dense indices
+  size_t sparse_bytes = 0;
+  /// Bytes allocated for the dense entity array and other per-component
+  /// bookkeeping, including unused capacity
+  size_t index_bytes = 0;
+  /// Bytes of dense and index storage allocated but not holding a component
+  size_t slack_bytes = 0;
+  /// Fraction of allocated sparse slots that are empty, from 0 to 1
+  double fragmentation = 0.0;
+
+  /// \brief Gets the total bytes allocated
+  /// \return Dense, sparse and index bytes combined
+  inline size_t total_bytes() const
+  {
+    return dense_bytes + sparse_bytes + index_bytes;
+  }
+
+  /// \brief Adds another containers stats to this one
+  /// \param other Stats to add
+  /// \return This
+  MemoryStats& operator+=(const MemoryStats& other)
+  {
+    auto slots = sparse_bytes + other.sparse_bytes;
+    if ( slots > 0 ) {
+      fragmentation = (fragmentation * sparse_bytes
+        + other.fragmentation * other.sparse_bytes) / slots;
+    }
+
+    count += other.count;
+    capacity += other.capacity;
+    dense_bytes += other.dense_bytes;
+    sparse_bytes += other.sparse_bytes;
+    index_bytes += other.index_bytes;
+    slack_bytes += other.slack_bytes;
+    return *this;
+  }
+};
+
+/// \brief SparseSet maps Entity ids to a densely packed array of indices.
+/// \details The sparse side of the set is split into fixed-size pages that are
+/// only allocated the first time an id inside their range is inserted, so
+/// memory scales with the ids actually in use rather than the whole id space.
+/// The dense side holds every contained Entity contiguously and is kept in the
+/// same order as any data stored alongside it (see ComponentData)
+class SparseSet {
+public:
+  /// \brief Index value used to mark an empty slot in the sparse pages
+  static constexpr EntityId null_index = std::numeric_limits<EntityId>::max();
+
+  /// \brief Number of entity ids covered by a single sparse page
+  static constexpr uint32_t page_size = 4096;
+
+  /// \brief Gets the dense index of an entity
+  /// \param entity Entity to look up
+  /// \return The index into the dense array if the entity is contained and
+  /// its generation matches, null_index otherwise
+  inline EntityId index_of(const Entity& entity) const
+  {
+    auto page = entity.id / page_size;
+    if ( page >= pages_.size() || !pages_[page] )
+      return null_index;
+
+    auto index = pages_[page][entity.id % page_size];
+    if ( index == null_index || dense_[index].generation != entity.generation )
+      return null_index;
+
+    return index;
+  }
+
+  /// \brief Checks to see if the entity is contained in the set
+  /// \param entity Entity to check for
+  /// \return True if found, false otherwise
+  inline bool contains(const Entity& entity) const
+  {
+    return index_of(entity) != null_index;
+  }
+
+  /// \brief Adds an entity to the back of the dense array, allocating its
+  /// sparse page if needed
+  /// \param entity Entity to insert
+  /// \return The dense index the entity was inserted at
+  inline EntityId insert(const Entity& entity)
+  {
+    auto index = static_cast<EntityId>(dense_.size());
+    dense_.push_back(entity);
+    page_for(entity.id)[entity.id % page_size] = index;
+    return index;
+  }
+
+  /// \brief Adds a range of entities to the back of the dense array in one
+  /// pass, allocating their sparse pages if needed
+  /// \param entities First entity to insert
+  /// \param count Number of entities to insert
+  /// \return The dense index the first entity was inserted at
+  inline EntityId insert(const Entity* entities, size_t count)
+  {
+    auto first = static_cast<EntityId>(dense_.size());
+    dense_.insert(dense_.end(), entities, entities + count);
+    for ( size_t i = 0; i < count; ++i ) {
+      auto id = entities[i].id;
+      page_for(id)[id % page_size] = static_cast<EntityId>(first + i);
+    }
+    return first;
+  }
+
+  /// \brief Reserves room in the dense array
+  /// \param capacity Number of entities to reserve room for
+  inline void reserve(size_t capacity) { dense_.reserve(capacity); }
+
+  /// \brief Removes an entity by moving the last dense entity into its slot.
+  /// Any data stored alongside the set must be swapped the same way
+  /// \param entity Entity to remove
+  /// \return The dense index that was vacated, or null_index if the entity
+  /// wasn't contained
+  inline EntityId erase(const Entity& entity)
+  {
+    auto index = index_of(entity);
+    if ( index == null_index )
+      return null_index;
+
+    auto& last = dense_.back();
+    dense_[index] = last;
+    pages_[last.id / page_size][last.id % page_size] = index;
+    pages_[entity.id / page_size][entity.id % page_size] = null_index;
+    dense_.pop_back();
+    return index;
+  }
+
+  /// \brief Swaps two entities positions in the dense array, patching their
+  /// sparse slots. Any data stored alongside the set must be swapped the same
+  /// way
+  /// \param a Dense index of the first entity
+  /// \param b Dense index of the second entity
+  inline void swap(EntityId a, EntityId b)
+  {
+    std::swap(dense_[a], dense_[b]);
+    pages_[dense_[a].id / page_size][dense_[a].id % page_size] = a;
+    pages_[dense_[b].id / page_size][dense_[b].id % page_size] = b;
+  }
+
+  /// \brief Reorders the dense array, patching every sparse slot. Any data
+  /// stored alongside the set must be reordered the same way
+  /// \param order Old dense index of the entity to place at each new index.
+  /// Must be a permutation of every dense index
+  inline void permute(const std::vector<EntityId>& order)
+  {
+    std::vector<Entity> dense(dense_.size());
+    for ( size_t i = 0; i < order.size(); ++i ) {
+      dense[i] = dense_[order[i]];
+      pages_[dense[i].id / page_size][dense[i].id % page_size] = static_cast<EntityId>(i);
+    }
+    dense_.swap(dense);
+  }
+
+  /// \brief Gets all contained entities in dense order
+  /// \return The dense entity array
+  inline const std::vector<Entity>& entities() const { return dense_; }
+
+  /// \brief Adds the sets sparse pages and dense entity array to stats
+  /// \param stats Stats to add to
+  void memory(MemoryStats& stats) const
+  {
+    size_t pages = 0;
+    for ( auto& page : pages_ )
+      pages += page ? 1 : 0;
+
+    auto slots = pages * page_size;
+    stats.sparse_bytes += slots * sizeof(EntityId)
+      + pages_.capacity() * sizeof(pages_[0]);
+    stats.index_bytes += dense_.capacity() * sizeof(Entity);
+    stats.slack_bytes += (dense_.capacity() - dense_.size()) * sizeof(Entity);
+    stats.fragmentation = slots > 0
+      ? 1.0 - static_cast<double>(dense_.size()) / slots
+      : 0.0;
+  }
+
+  /// \brief Frees sparse pages holding no entities and unused dense capacity
+  void shrink_to_fit()
+  {
+    std::vector<bool> used(pages_.size(), false);
+    for ( auto& entity : dense_ )
+      used[entity.id / page_size] = true;
+
+    for ( size_t page = 0; page < pages_.size(); ++page ) {
+      if ( !used[page] )
+        pages_[page].reset();
+    }
+
+    while ( !pages_.empty() && !pages_.back() )
+      pages_.pop_back();
+
+    pages_.shrink_to_fit();
+    dense_.shrink_to_fit();
+  }
+
+  /// \brief Writes the dense entity array to a snapshot. The sparse pages
+  /// are rebuilt from it on load()
+  /// \param writer Snapshot to write to
+  inline void save(SnapshotWriter& writer) const { writer.write_array(dense_); }
+
+  /// \brief Replaces the contents of the set with a saved dense array. Only
+  /// slots whose entity changed are patched, so loading a snapshot with the
+  /// same layout doesn't touch the sparse pages
+  /// \param reader Snapshot to read from
+  void load(SnapshotReader& reader)
+  {
+    size_t count = 0;
+    auto saved = reader.view_array<Entity>(count);
+
+    for ( size_t i = 0; i < std::max(count, dense_.size()); ++i ) {
+      if ( i < count && i < dense_.size() && saved[i].id == dense_[i].id
+           && saved[i].generation == dense_[i].generation )
+        continue;
+
+      // The old entity may already have been patched to a later index
+      if ( i < dense_.size() ) {
+        auto& slot = pages_[dense_[i].id / page_size][dense_[i].id % page_size];
+        if ( slot == i )
+          slot = null_index;
+      }
+
+      if ( i < count )
+        page_for(saved[i].id)[saved[i].id % page_size] = static_cast<EntityId>(i);
+    }
+
+    dense_.assign(saved, saved + count);
+  }
+
+  /// \brief Gets the number of contained entities
+  /// \return Number of entities in the set
+  inline size_t size() const { return dense_.size(); }
+
+private:
+  /// \brief Lazily allocated pages of dense indices, indexed by entity id
+  std::vector<std::unique_ptr<EntityId[]>> pages_;
+  /// \brief All contained entities, packed contiguously
+  std::vector<Entity> dense_;
+
+  /// \brief Gets the sparse page containing an id, allocating it if needed
+  /// \param id Entity id to get the page for
+  /// \return Pointer to the first slot of the page
+  EntityId* page_for(EntityId id)
+  {
+    auto page = id / page_size;
+    if ( page >= pages_.size() )
+      pages_.resize(page + 1);
+
+    if ( !pages_[page] ) {
+      pages_[page].reset(new EntityId[page_size]);
+      std::fill_n(pages_[page].get(), page_size, EntityId(null_index));
+    }
+
+    return pages_[page].get();
+  }
 };
 
 /// \brief ComponentData is a container of components with garunteed contiguous
 /// storage that can be queried with an Entity id
 /// \tparam Type of component to store
-template <typename T>
+/// \tparam Alloc Allocator policy for instances. Defaults to cache line aligned
+/// storage so SIMD passes over instances never split a line. Only instances
+/// use it: versions are always an AlignedVector and the sparse set uses the
+/// default allocator. Storage other than ComponentData, such as TransformData
+/// and BoxData, and EntityMap's own tables don't take a policy at all
+template <typename T, typename Alloc = AlignedAllocator<T>>
 struct ComponentData {
 
-  /// \brief All instances of this component mapped to an entity
-  std::vector<T> instances;
+  /// Allocator policy used for instances
+  using allocator_type = Alloc;
+  /// Type of component stored
+  using value_type = T;
+  /// Pointer-like handle to a component, as returned by EntityMap::get()
+  using pointer = T*;
 
-  /// \brief Initializes the container and lookup table
-  ComponentData()
-  {
-    for ( int e = 0; e < UINT16_MAX; ++e ) {
-      lookup_[e].id = e;
-      lookup_[e].index = UINT16_MAX;
-      lookup_[e].generation = UINT16_MAX;
-    }
-  }
+  /// \brief All instances of this component mapped to an entity. Kept in the
+  /// same order as the entities in the underlying SparseSet. Writing to it
+  /// directly isn't counted as a change, call touch() after doing so
+  std::vector<T, Alloc> instances;
 
   /// \brief Gets an entities associated component as a pointer.
   /// \details Uses a pointer rather than a reference to allow for better
@@ -54,11 +347,23 @@ struct ComponentData {
   /// \return Pointer to the component instance if found, nullptr otherwise
   inline T* get(const Entity& entity)
   {
-    auto lookup = lookup_[entity.id];
-    if ( lookup.generation != entity.generation )
+    auto index = entities_.index_of(entity);
+    if ( index == SparseSet::null_index )
       return nullptr;
 
-    return (lookup.index < UINT16_MAX) ? &instances[lookup.index] : nullptr;
+    if ( tracking_ )
+      versions_[index] = version_;
+    return &instances[index];
+  }
+
+  /// \brief Gets an entities associated component for reading, which isn't
+  /// counted as a change
+  /// \param entity The entity whose component is being retrieved
+  /// \return Pointer to the component instance if found, nullptr otherwise
+  inline const T* read(const Entity& entity) const
+  {
+    auto index = entities_.index_of(entity);
+    return (index != SparseSet::null_index) ? &instances[index] : nullptr;
   }
 
   /// \brief Checks to see if the entity has an instance of the component
@@ -66,40 +371,982 @@ struct ComponentData {
   /// \return True if found, false otherwise
   inline bool has_component(const Entity& entity)
   {
-    auto lookup = lookup_[entity.id];
-    if ( lookup.generation != entity.generation )
-      return false;
-
-    return lookup.index < instances.size() && lookup.index < UINT16_MAX;
+    return entities_.contains(entity);
   }
 
   /// \brief Attaches an instance of the component to an entity
   /// \param entity Entity to attach
-  /// \return The entity with id and index into the data
-  inline Entity attach(const Entity& entity)
+  /// \return Pointer to the newly attached component instance
+  inline T* attach(const Entity& entity)
   {
     instances.emplace_back();
-    Entity e;
-    e.index = instances.size() - 1;
-    e.id = entity.id;
-    e.generation = entity.generation;
-    lookup_[e.id] = e;
-    return e;
+    entities_.insert(entity);
+    unsort();
+    if ( tracking_ )
+      versions_.push_back(version_);
+    return &instances.back();
   }
 
-  /// \brief Removes an entity from this container
+  /// \brief Attaches a default constructed instance to each of a range of
+  /// entities, growing the storage once rather than per entity
+  /// \param entities First entity to attach
+  /// \param count Number of entities to attach
+  /// \return Pointer to the first newly attached instance, the rest follow it
+  inline T* attach(const Entity* entities, size_t count)
+  {
+    auto first = instances.size();
+    instances.resize(first + count);
+    entities_.insert(entities, count);
+    unsort();
+    if ( tracking_ )
+      versions_.resize(first + count, version_);
+    return instances.data() + first;
+  }
+
+  /// \brief Reserves room for instances so attaching up to capacity doesn't
+  /// reallocate
+  /// \param capacity Number of instances to reserve room for
+  inline void reserve(size_t capacity)
+  {
+    instances.reserve(capacity);
+    entities_.reserve(capacity);
+  }
+
+  /// \brief Removes an entity from this container. Does nothing if the entity
+  /// has no instance of the component
   /// \param entity Entity to remove
   inline void detach(const Entity& entity)
   {
-    auto index = lookup_[entity.id].index;
-    std::swap(*get(entity), instances.back());
+    auto index = entities_.erase(entity);
+    if ( index == SparseSet::null_index )
+      return;
+
+    if ( index != instances.size() - 1 )
+      instances[index] = std::move(instances.back());
+
     instances.pop_back();
-    lookup_[entity.id].index = UINT16_MAX;
+    unsort();
+
+    // The moved instance has a new index, which counts as a change
+    if ( tracking_ ) {
+      versions_[index] = version_;
+      versions_.pop_back();
+    }
+  }
+
+  /// \brief Gets the entities owning each instance, in the same order as
+  /// instances
+  /// \return The dense entity array
+  inline const std::vector<Entity>& entities() const
+  {
+    return entities_.entities();
+  }
+
+  /// \brief Sorts instances by a key, keeping every entity lookup valid. Use
+  /// it to group instances for batching, e.g. by texture, or to make spatially
+  /// close instances adjacent, e.g. by Morton code
+  /// \param key Function called as key(const T&), returning a value ordered
+  /// by std::less. Instances with equal keys keep their relative order
+  template <typename Key>
+  void sort_by(Key&& key)
+  {
+    std::vector<EntityId> order;
+    sorted_order(key, order);
+    permute(order);
+    sorted_ = true;
+    sortKey_ = key_identity<typename std::decay<Key>::type>();
+  }
+
+  /// \brief Reorders instances, keeping every entity lookup valid. Use it
+  /// when the order comes from outside the instances, e.g. a systems own
+  /// traversal order
+  /// \param order Current index of the instance to put in each slot, holding
+  /// every index exactly once
+  void permute(const std::vector<EntityId>& order)
+  {
+    std::vector<T, Alloc> permuted;
+    permuted.reserve(order.size());
+    for ( auto index : order )
+      permuted.push_back(std::move(instances[index]));
+
+    instances.swap(permuted);
+    entities_.permute(order);
+    unsort();
+
+    // Instances changed index, which counts as a change
+    if ( tracking_ )
+      std::fill(versions_.begin(), versions_.end(), version_);
+  }
+
+  /// \brief Moves instances towards the order sort_by() would give, making at
+  /// most a fixed number of swaps so the cost can be spread across frames.
+  /// The first step sorts the keys to find each instances target slot, and
+  /// every swap after that puts at least one instance in its slot, so a sort
+  /// finishes in fewer than one swap per instance. Once sorted, further steps
+  /// are free until instances are added or removed or a key of a different
+  /// type is given, which restarts the sort. Keys are told apart by type, so
+  /// keys changed in place, or functors of one type with different state,
+  /// need sort_by()
+  /// \param key Function called as key(const T&), as in sort_by()
+  /// \param maxSwaps Most swaps to make
+  /// \return True if the instances are fully sorted, false if more steps are
+  /// needed
+  template <typename Key>
+  bool sort_step(Key&& key, size_t maxSwaps)
+  {
+    auto identity = key_identity<typename std::decay<Key>::type>();
+    if ( identity != sortKey_ ) {
+      unsort();
+      sortKey_ = identity;
+    }
+
+    if ( sorted_ )
+      return true;
+
+    auto count = instances.size();
+    if ( sortSlots_.size() != count ) {
+      std::vector<EntityId> order;
+      sorted_order(key, order);
+
+      sortSlots_.resize(count);
+      for ( size_t i = 0; i < count; ++i )
+        sortSlots_[order[i]] = static_cast<EntityId>(i);
+      sortCursor_ = 0;
+    }
+
+    // Walks each cycle of the permutation from the cursor, swapping the
+    // instance at the cursor into its slot until the cursor's own instance
+    // arrives
+    size_t swaps = 0;
+    while ( sortCursor_ < count ) {
+      auto i = static_cast<EntityId>(sortCursor_);
+      auto slot = sortSlots_[i];
+      if ( slot == i ) {
+        sortCursor_++;
+        continue;
+      }
+
+      if ( swaps == maxSwaps )
+        return false;
+
+      std::swap(instances[i], instances[slot]);
+      std::swap(sortSlots_[i], sortSlots_[slot]);
+      entities_.swap(i, slot);
+      if ( tracking_ )
+        versions_[i] = versions_[slot] = version_;
+      swaps++;
+    }
+
+    sortSlots_.clear();
+    sorted_ = true;
+    return true;
+  }
+
+  /// \brief Gets the memory held by this container
+  /// \return The containers stats
+  MemoryStats memory() const
+  {
+    MemoryStats stats;
+    stats.count = instances.size();
+    stats.capacity = instances.capacity();
+    stats.dense_bytes = instances.capacity() * sizeof(T);
+    stats.index_bytes = versions_.capacity() * sizeof(uint32_t)
+      + sortSlots_.capacity() * sizeof(EntityId);
+    stats.slack_bytes = (instances.capacity() - instances.size()) * sizeof(T)
+      + (versions_.capacity() - versions_.size()) * sizeof(uint32_t);
+    entities_.memory(stats);
+    return stats;
+  }
+
+  /// \brief Frees unused capacity and empty sparse pages
+  void shrink_to_fit()
+  {
+    instances.shrink_to_fit();
+    versions_.shrink_to_fit();
+    sortSlots_.shrink_to_fit();
+    entities_.shrink_to_fit();
+  }
+
+  /// \brief Writes every instance and the entity each belongs to. T must be
+  /// trivially copyable
+  /// \param writer Snapshot to write to
+  void save(SnapshotWriter& writer) const
+  {
+    writer.write_array(instances);
+    entities_.save(writer);
+  }
+
+  /// \brief Replaces every instance with those from save(). Versions aren't
+  /// rewound, instead every loaded instance counts as changed
+  /// \param reader Snapshot to read from
+  void load(SnapshotReader& reader)
+  {
+    reader.read_array(instances);
+    entities_.load(reader);
+    if ( tracking_ )
+      versions_.assign(instances.size(), version_);
+
+    unsort();
+  }
+
+  /// \brief Starts stamping each instance with the current version whenever
+  /// it's attached, moved, touched or accessed through get(), parallel_for()
+  /// or a View, so readers can skip instances that haven't changed
+  inline void track_changes()
+  {
+    tracking_ = true;
+    versions_.assign(instances.size(), version_);
+  }
+
+  /// \brief Stamps an instance with the current version, for instances
+  /// written directly through instances
+  /// \param index Index of the instance
+  inline void touch(size_t index)
+  {
+    if ( tracking_ )
+      versions_[index] = version_;
+  }
+
+  /// \brief Gets a handle to an instance by index, without stamping it
+  /// \param index Index of the instance
+  /// \return Pointer to the instance
+  inline T* component_at(size_t index) { return &instances[index]; }
+
+  /// \brief Gets the version changes are currently stamped with
+  /// \return The current version
+  inline uint32_t version() const { return version_; }
+
+  /// \brief Ends the current version so later changes can be told apart from
+  /// earlier ones. Readers keep the returned value and pass it to
+  /// changed_since() or each_changed() next time
+  /// \return The version that was current
+  inline uint32_t mark() { return version_++; }
+
+  /// \brief Checks if an instance changed after a mark. Always true if
+  /// changes aren't tracked
+  /// \param index Index of the instance
+  /// \param since Value returned by an earlier mark(), or 0 for all instances
+  /// \return True if the instance changed since then
+  inline bool changed_since(size_t index, uint32_t since) const
+  {
+    return !tracking_ || versions_[index] > since;
+  }
+
+  /// \brief Calls a function for every instance changed after a mark. The
+  /// instance is passed mutably but isn't stamped again
+  /// \param since Value returned by an earlier mark(), or 0 for all instances
+  /// \param fn Function called as fn(const Entity&, T&)
+  template <typename Fn>
+  void each_changed(uint32_t since, Fn&& fn)
+  {
+    auto& entities = entities_.entities();
+    for ( size_t i = 0; i < instances.size(); ++i ) {
+      if ( changed_since(i, since) )
+        fn(entities[i], instances[i]);
+    }
+  }
+
+  /// \brief Calls a function for every instance, splitting instances into
+  /// ranges that run in parallel on a job pool. Ranges start on a cache line
+  /// of both the instances and their versions, as both are written
+  /// \param fn Function called as fn(const Entity&, T&). Must be safe to call
+  /// concurrently for different instances
+  /// \param grain Target number of instances per job
+  /// \param pool Pool to run jobs on
+  template <typename Fn>
+  void parallel_for(Fn&& fn, size_t grain = 4096, JobPool& pool = JobPool::shared())
+  {
+    auto& entities = entities_.entities();
+    parallel_ranges([&](size_t begin, size_t end) {
+      if ( tracking_ )
+        std::fill(versions_.begin() + begin, versions_.begin() + end, version_);
+      for ( auto i = begin; i < end; ++i )
+        fn(entities[i], instances[i]);
+    }, grain, pool);
+  }
+
+  /// \brief Splits the instance indices into ranges that run in parallel on
+  /// a job pool. Ranges start on a cache line of every array written when an
+  /// instance is written: the instances and, if tracking, their versions
+  /// \param fn Function called as fn(begin, end) for each range
+  /// \param grain Target number of instances per job
+  /// \param pool Pool to run jobs on
+  template <typename Fn>
+  void parallel_ranges(Fn&& fn, size_t grain = 4096, JobPool& pool = JobPool::shared())
+  {
+    if ( tracking_ )
+      ecs::parallel_for(instances.data(), versions_.data(), instances.size(), grain, fn, pool);
+    else
+      ecs::parallel_for(instances.data(), instances.size(), grain, fn, pool);
+  }
+
+  /// \brief Gets the index of an entities component in instances
+  /// \param entity Entity to look up
+  /// \return The index if found, SparseSet::null_index otherwise
+  inline EntityId index_of(const Entity& entity) const
+  {
+    return entities_.index_of(entity);
+  }
+
+private:
+  /// \brief Sparse set used to index into the actual data
+  SparseSet entities_;
+  /// \brief Version each instance last changed at, if tracking changes.
+  /// Cache line aligned so parallel_for() can split it on the same lines as
+  /// instances
+  AlignedVector<uint32_t> versions_;
+  /// \brief Version stamped on changes
+  uint32_t version_ = 1;
+  bool tracking_ = false;
+  /// \brief Target slot of each instance while sort_step() is part way
+  /// through a sort, empty otherwise
+  std::vector<EntityId> sortSlots_;
+  /// \brief Slot sort_step() resumes from, every slot before it is final
+  size_t sortCursor_ = 0;
+  /// \brief Set once sorted, cleared when instances are added or removed
+  bool sorted_ = false;
+  /// \brief Identity of the key type sorted_ and sortSlots_ refer to
+  const void* sortKey_ = nullptr;
+
+  /// \brief Gets a value unique to a key type, used to tell which key the
+  /// instances were last sorted by
+  /// \return The identity
+  template <typename Key>
+  static const void* key_identity()
+  {
+    static const char identity = 0;
+    return &identity;
+  }
+
+  /// \brief Finds the order sort_by() would put instances in
+  /// \param key Function called as key(const T&)
+  /// \param order Set to the current index of the instance for each slot
+  template <typename Key>
+  void sorted_order(Key& key, std::vector<EntityId>& order) const
+  {
+    auto count = instances.size();
+    using KeyType = typename std::decay<decltype(key(instances[0]))>::type;
+
+    std::vector<std::pair<KeyType, EntityId>> keys;
+    keys.reserve(count);
+    for ( size_t i = 0; i < count; ++i )
+      keys.emplace_back(key(instances[i]), static_cast<EntityId>(i));
+
+    std::stable_sort(keys.begin(), keys.end(),
+      [](const std::pair<KeyType, EntityId>& a, const std::pair<KeyType, EntityId>& b) {
+        return std::less<KeyType>()(a.first, b.first);
+      });
+
+    order.resize(count);
+    for ( size_t i = 0; i < count; ++i )
+      order[i] = keys[i].second;
+  }
+
+  /// \brief Drops any sort in progress after instances are added or removed
+  inline void unsort()
+  {
+    sortSlots_.clear();
+    sorted_ = false;
+  }
+};
+
+/// \brief Most component types a process can use, as each is given a bit in
+/// the 64 bit archetype signatures and Access masks
+constexpr uint32_t max_component_types = 64;
+
+static_assert(max_component_types <= sizeof(uint64_t) * 8,
+              "Every component type needs a bit in an archetype signature");
+
+/// \brief Gets a unique, densely packed id for a component type. Ids are
+/// assigned in order of first use, starting at zero. Like system ids they're
+/// global to the process, so every component type used anywhere counts
+/// towards max_component_types
+/// \tparam Type of component to get the id for
+/// \return The component types id
+template <typename T>
+inline uint32_t component_id();
+
+/// \brief ComponentInfo holds the type-erased size, alignment and lifetime
+/// operations for a component type so it can be stored in raw chunk memory
+struct ComponentInfo {
+  size_t size;
+  size_t align;
+  void (*construct)(void* dst);
+  void (*destroy)(void* dst);
+  /// Move constructs dst from src and destroys src
+  void (*relocate)(void* dst, void* src);
+
+  /// \brief Gets the info for a component type
+  /// \tparam Type of component
+  /// \return The components size, alignment and lifetime operations
+  template <typename T>
+  static ComponentInfo of()
+  {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "Over-aligned components can't be stored in chunks");
+
+    ComponentInfo info;
+    info.size = sizeof(T);
+    info.align = alignof(T);
+    info.construct = [](void* dst) { new (dst) T(); };
+    info.destroy = [](void* dst) { static_cast<T*>(dst)->~T(); };
+    info.relocate = [](void* dst, void* src) {
+      new (dst) T(std::move(*static_cast<T*>(src)));
+      static_cast<T*>(src)->~T();
+    };
+    return info;
+  }
+};
+
+/// \brief Registry of ComponentInfo for every component type given an id
+/// \return All known component infos, indexed by component id
+inline std::vector<ComponentInfo>& component_infos()
+{
+  static std::vector<ComponentInfo> infos;
+  return infos;
+}
+
+template <typename T>
+inline uint32_t component_id()
+{
+  static const uint32_t id = [] {
+    auto& infos = component_infos();
+    infos.push_back(ComponentInfo::of<T>());
+    return static_cast<uint32_t>(infos.size() - 1);
+  }();
+  assert(id < max_component_types && "Too many component types for a signature");
+  return id;
+}
+
+/// \brief Gets a bitmask with the bit of each component types id set
+/// \tparam Ts Component types to include
+/// \return The mask
+template <typename... Ts>
+inline uint64_t component_mask()
+{
+  uint64_t mask = 0;
+  for ( auto id : { uint32_t(0), (component_id<Ts>() + 1)... } ) {
+    if ( id > 0 )
+      mask |= uint64_t(1) << (id - 1);
+  }
+  return mask;
+}
+
+/// \brief Most resource types a process can use, as each is given a bit in
+/// the 64 bit Access resource masks
+constexpr uint32_t max_resource_types = 64;
+
+/// \brief Gets the next unused resource id
+/// \return The id
+inline uint32_t next_resource_id()
+{
+  static uint32_t next = 0;
+  return next++;
+}
+
+/// \brief Gets a unique, densely packed id for a resource type, shared state
+/// other than components that systems declare access to, such as one
+/// systems results read by another. Resources have their own id space, so
+/// unlike using component_id() they don't register a component type or use
+/// up a component bit
+/// \tparam Type of resource to get the id for
+/// \return The resource types id
+template <typename T>
+inline uint32_t resource_id()
+{
+  static const uint32_t id = next_resource_id();
+  assert(id < max_resource_types && "Too many resource types for an access mask");
+  return id;
+}
+
+/// \brief Gets a bitmask with the bit of each resource types id set
+/// \tparam Ts Resource types to include
+/// \return The mask
+template <typename... Ts>
+inline uint64_t resource_mask()
+{
+  uint64_t mask = 0;
+  for ( auto id : { uint32_t(0), (resource_id<Ts>() + 1)... } ) {
+    if ( id > 0 )
+      mask |= uint64_t(1) << (id - 1);
+  }
+  return mask;
+}
+
+/// \brief Archetype stores every entity that has exactly the same set of
+/// components. Entities are packed into fixed-size chunks, each holding an
+/// entity column followed by one column per component, so iterating a set of
+/// components streams linearly through memory
+class Archetype {
+public:
+  /// \brief Size in bytes of each chunk
+  static constexpr size_t chunk_size = 16 * 1024;
+
+  /// \brief Initializes an empty archetype and computes its chunk layout
+  /// \param signature Bitmask of the component ids stored in this archetype
+  explicit Archetype(uint64_t signature)
+    : signature_(signature), size_(0)
+  {
+    auto& infos = component_infos();
+    size_t rowSize = sizeof(Entity);
+    for ( uint32_t id = 0; id < infos.size(); ++id ) {
+      if ( signature_ & (uint64_t(1) << id) )
+        rowSize += infos[id].size;
+    }
+
+    capacity_ = std::max<size_t>(1, chunk_size / rowSize);
+
+    // Shrink the row count until every column fits after alignment padding
+    while ( layout(capacity_) > chunk_size && capacity_ > 1 )
+      capacity_--;
+
+    chunkBytes_ = layout(capacity_);
+    if ( chunkBytes_ < chunk_size )
+      chunkBytes_ = chunk_size;
+  }
+
+  /// \brief Destroys all components stored in the archetype
+  ~Archetype()
+  {
+    for ( size_t row = 0; row < size_; ++row )
+      destroy_row(row);
+
+    for ( auto chunk : chunks_ )
+      free_chunk(chunk);
+  }
+
+  Archetype(const Archetype&) = delete;
+  Archetype& operator=(const Archetype&) = delete;
+
+  /// \brief Gets the bitmask of component ids stored in this archetype
+  /// \return The signature
+  inline uint64_t signature() const { return signature_; }
+
+  /// \brief Checks if this archetype stores a component
+  /// \param id Component id to check for
+  /// \return True if a column exists for the component, false otherwise
+  inline bool has_column(uint32_t id) const
+  {
+    assert(id < max_component_types && "Component id out of signature range");
+    return (signature_ & (uint64_t(1) << id)) != 0;
+  }
+
+  /// \brief Gets the number of entities stored in the archetype
+  /// \return Number of entities
+  inline size_t size() const { return size_; }
+
+  /// \brief Gets the maximum number of entities stored in a single chunk
+  /// \return Rows per chunk
+  inline size_t chunk_capacity() const { return capacity_; }
+
+  /// \brief Gets the number of chunks holding at least one entity
+  /// \return Number of chunks in use
+  inline size_t chunk_count() const
+  {
+    return (size_ + capacity_ - 1) / capacity_;
+  }
+
+  /// \brief Gets the bytes allocated for chunks, including the spare chunk
+  /// \return Bytes allocated
+  inline size_t reserved_bytes() const { return chunks_.size() * chunkBytes_; }
+
+  /// \brief Gets the number of entities stored in a chunk
+  /// \param chunk Index of the chunk
+  /// \return Number of used rows in the chunk
+  inline size_t chunk_rows(size_t chunk) const
+  {
+    return std::min(capacity_, size_ - chunk * capacity_);
+  }
+
+  /// \brief Gets the entity column of a chunk
+  /// \param chunk Index of the chunk
+  /// \return Pointer to the first entity in the chunk
+  inline Entity* entities(size_t chunk)
+  {
+    return reinterpret_cast<Entity*>(chunks_[chunk]);
+  }
+
+  /// \brief Gets a components column in a chunk
+  /// \tparam Type of component
+  /// \param chunk Index of the chunk
+  /// \return Pointer to the first component in the chunk
+  template <typename T>
+  inline T* column(size_t chunk)
+  {
+    return reinterpret_cast<T*>(
+      chunks_[chunk] + offsets_[component_id<T>()]
+    );
+  }
+
+  /// \brief Gets the entity stored in a row
+  /// \param row Row to get
+  /// \return The entity
+  inline Entity& entity(size_t row)
+  {
+    return entities(row / capacity_)[row % capacity_];
+  }
+
+  /// \brief Gets a pointer to a component in a row
+  /// \param row Row the component is in
+  /// \param id Component id to get
+  /// \return Pointer to the raw component memory
+  inline void* at(size_t row, uint32_t id)
+  {
+    return chunks_[row / capacity_] + offsets_[id]
+      + (row % capacity_) * component_infos()[id].size;
+  }
+
+  /// \brief Appends a new row, allocating a chunk if needed. The rows
+  /// components are left uninitialized
+  /// \param entity Entity owning the row
+  /// \return The new row
+  inline size_t push_row(const Entity& entity)
+  {
+    if ( size_ == chunks_.size() * capacity_ )
+      chunks_.push_back(allocate_chunk());
+
+    auto row = size_++;
+    entity_at(row) = entity;
+    return row;
+  }
+
+  /// \brief Destroys all components in a row without removing it
+  /// \param row Row to destroy
+  inline void destroy_row(size_t row)
+  {
+    auto& infos = component_infos();
+    for ( auto id : columns_ )
+      infos[id].destroy(at(row, id));
+  }
+
+  /// \brief Removes a row whose components have already been destroyed or
+  /// relocated by moving the last row into its place
+  /// \param row Row to remove
+  /// \param moved Set to the entity that was moved into the row, if any
+  /// \return True if an entity was moved into the row, false otherwise
+  inline bool pop_row(size_t row, Entity& moved)
+  {
+    auto last = --size_;
+    if ( row != last ) {
+      auto& infos = component_infos();
+      for ( auto id : columns_ )
+        infos[id].relocate(at(row, id), at(last, id));
+
+      moved = entity_at(last);
+      entity_at(row) = moved;
+    }
+
+    // Keep one spare chunk so churn at a chunk boundary doesn't reallocate
+    if ( chunks_.size() > 1 && size_ <= (chunks_.size() - 2) * capacity_ ) {
+      free_chunk(chunks_.back());
+      chunks_.pop_back();
+    }
+
+    return row != last;
+  }
+
+private:
+  /// \brief Bitmask of the component ids stored in this archetype
+  uint64_t signature_;
+  /// \brief Component ids with a column in this archetype
+  std::vector<uint32_t> columns_;
+  /// \brief Byte offset of each components column in a chunk, indexed by id
+  std::vector<size_t> offsets_;
+  /// \brief Fixed-size blocks of column data. Chunks of chunk_size come from
+  /// BlockPool::chunks() so they never move and are recycled between archetypes
+  std::vector<unsigned char*> chunks_;
+  /// \brief Number of entities stored
+  size_t size_;
+  /// \brief Rows per chunk
+  size_t capacity_;
+  /// \brief Allocated size of each chunk
+  size_t chunkBytes_;
+
+  /// \brief Gets a chunk from the shared pool, or from the heap if rows are
+  /// too large for a pool block
+  inline unsigned char* allocate_chunk()
+  {
+    auto& pool = BlockPool::chunks();
+    if ( chunkBytes_ <= pool.block_size() )
+      return static_cast<unsigned char*>(pool.allocate());
+
+    return static_cast<unsigned char*>(allocate_aligned(chunkBytes_));
+  }
+
+  /// \brief Returns a chunk from allocate_chunk()
+  inline void free_chunk(unsigned char* chunk)
+  {
+    auto& pool = BlockPool::chunks();
+    if ( chunkBytes_ <= pool.block_size() )
+      pool.deallocate(chunk);
+    else
+      deallocate_aligned(chunk);
+  }
+
+  /// \brief Gets the entity stored in a row
+  inline Entity& entity_at(size_t row)
+  {
+    return entities(row / capacity_)[row % capacity_];
+  }
+
+  /// \brief Lays out columns for a row count
+  /// \param rows Number of rows per chunk
+  /// \return The number of bytes needed by the layout
+  size_t layout(size_t rows)
+  {
+    auto& infos = component_infos();
+    columns_.clear();
+    offsets_.assign(infos.size(), 0);
+
+    auto offset = sizeof(Entity) * rows;
+    for ( uint32_t id = 0; id < infos.size(); ++id ) {
+      if ( !has_column(id) )
+        continue;
+
+      offset = (offset + infos[id].align - 1) / infos[id].align * infos[id].align;
+      offsets_[id] = offset;
+      columns_.push_back(id);
+      offset += infos[id].size * rows;
+    }
+
+    return offset;
+  }
+};
+
+/// \brief ArchetypeStorage groups entities by their exact set of components,
+/// storing each group in its own Archetype. Adding or removing a component
+/// moves the entity's row into the archetype matching its new set. Supports up
+/// to 64 distinct component types
+class ArchetypeStorage {
+public:
+
+  /// \brief Adds a default constructed component to an entity, moving it to
+  /// the archetype that includes the new component
+  /// \tparam Type of component to add
+  /// \param entity Entity to add the component to
+  /// \return Pointer to the new component, or nullptr if the handle is stale
+  template <typename T>
+  T* add(const Entity& entity)
+  {
+    auto id = component_id<T>();
+    auto* current = get<T>(entity);
+    if ( current != nullptr )
+      return current;
+
+    auto& location = location_for(entity);
+    if ( location.archetype != nullptr
+      && location.archetype->entity(location.row).generation != entity.generation )
+      return nullptr;
+
+    auto signature = signature_of(entity) | (uint64_t(1) << id);
+    auto row = move_to(entity, location, archetype_for(signature));
+    return static_cast<T*>(location.archetype->at(row, id));
+  }
+
+  /// \brief Removes a component from an entity, moving it to the archetype
+  /// without the component. Does nothing if the entity has no such component
+  /// \tparam Type of component to remove
+  /// \param entity Entity to remove the component from
+  template <typename T>
+  void remove(const Entity& entity)
+  {
+    if ( !has<T>(entity) )
+      return;
+
+    auto& location = locations_[entity.id];
+    auto signature = signature_of(entity) & ~(uint64_t(1) << component_id<T>());
+    move_to(entity, location, signature != 0 ? archetype_for(signature) : nullptr);
+  }
+
+  /// \brief Gets an entities component
+  /// \tparam Type of component to get
+  /// \param entity Entity whose component is being retrieved
+  /// \return Pointer to the component if found, nullptr otherwise
+  template <typename T>
+  T* get(const Entity& entity)
+  {
+    if ( !has<T>(entity) )
+      return nullptr;
+
+    auto& location = locations_[entity.id];
+    return static_cast<T*>(location.archetype->at(location.row, component_id<T>()));
+  }
+
+  /// \brief Checks if an entity has a component
+  /// \tparam Type of component to check for
+  /// \param entity Entity to check
+  /// \return True if the entity has the component, false otherwise
+  template <typename T>
+  bool has(const Entity& entity)
+  {
+    return (signature_of(entity) & (uint64_t(1) << component_id<T>())) != 0;
+  }
+
+  /// \brief Removes all of an entities components
+  /// \param entity Entity to destroy
+  void destroy(const Entity& entity)
+  {
+    if ( signature_of(entity) == 0 )
+      return;
+
+    move_to(entity, locations_[entity.id], nullptr);
+  }
+
+  /// \brief Calls a function for every entity that has all of the specified
+  /// components, streaming through each matching archetype chunk by chunk
+  /// \tparam Ts Component types to iterate
+  /// \param fn Function called as fn(Entity, Ts&...)
+  template <typename... Ts, typename Fn>
+  void each(Fn&& fn)
+  {
+    auto mask = component_mask<Ts...>();
+
+    for ( auto& pair : archetypes_ ) {
+      auto& archetype = *pair.second;
+      if ( (archetype.signature() & mask) != mask )
+        continue;
+
+      for ( size_t c = 0; c < archetype.chunk_count(); ++c ) {
+        each_in_chunk(archetype.entities(c), archetype.chunk_rows(c), fn,
+                      archetype.template column<Ts>(c)...);
+      }
+    }
+  }
+
+  /// \brief Calls a function for every entity that has all of the specified
+  /// components, running each matching chunk as a separate job
+  /// \tparam Ts Component types to iterate
+  /// \param fn Function called as fn(Entity, Ts&...). Must be safe to call
+  /// concurrently for different entities
+  /// \param pool Pool to run jobs on
+  template <typename... Ts, typename Fn>
+  void parallel_each(Fn&& fn, JobPool& pool = JobPool::shared())
+  {
+    auto mask = component_mask<Ts...>();
+    std::vector<std::pair<Archetype*, size_t>> chunks;
+
+    for ( auto& pair : archetypes_ ) {
+      if ( (pair.second->signature() & mask) != mask )
+        continue;
+
+      for ( size_t c = 0; c < pair.second->chunk_count(); ++c )
+        chunks.emplace_back(pair.second.get(), c);
+    }
+
+    ecs::parallel_for(chunks.data(), chunks.size(), 1,
+      [&](size_t begin, size_t end) {
+        for ( auto i = begin; i < end; ++i ) {
+          auto& archetype = *chunks[i].first;
+          auto c = chunks[i].second;
+          each_in_chunk(archetype.entities(c), archetype.chunk_rows(c), fn,
+                        archetype.template column<Ts>(c)...);
+        }
+      }, pool);
+  }
+
+  /// \brief Gets all archetypes created so far, keyed by signature
+  /// \return The archetype map
+  inline const std::unordered_map<uint64_t, std::unique_ptr<Archetype>>& archetypes() const
+  {
+    return archetypes_;
+  }
+
+private:
+  /// \brief Location of an entities row
+  struct Location {
+    Archetype* archetype;
+    size_t row;
+  };
+
+  /// \brief All archetypes, keyed by component signature
+  std::unordered_map<uint64_t, std::unique_ptr<Archetype>> archetypes_;
+  /// \brief Location of each entity, indexed by entity id
+  std::vector<Location> locations_;
+
+  /// \brief Gets the signature of the archetype an entity currently lives in
+  /// \param entity Entity to check
+  /// \return The signature, or zero if the entity has no components or the
+  /// handle is stale
+  inline uint64_t signature_of(const Entity& entity)
+  {
+    if ( entity.id >= locations_.size() )
+      return 0;
+
+    auto& location = locations_[entity.id];
+    if ( location.archetype == nullptr
+      || location.archetype->entity(location.row).generation != entity.generation )
+      return 0;
+
+    return location.archetype->signature();
+  }
+
+  /// \brief Gets an entities location, growing the location table if needed
+  inline Location& location_for(const Entity& entity)
+  {
+    if ( entity.id >= locations_.size() )
+      locations_.resize(entity.id + 1, Location { nullptr, 0 });
+
+    return locations_[entity.id];
+  }
+
+  /// \brief Gets the archetype for a signature, creating it if needed
+  inline Archetype* archetype_for(uint64_t signature)
+  {
+    auto& archetype = archetypes_[signature];
+    if ( !archetype )
+      archetype.reset(new Archetype(signature));
+
+    return archetype.get();
+  }
+
+  /// \brief Moves an entities row to another archetype, relocating shared
+  /// components, constructing new ones and destroying dropped ones
+  /// \param entity Entity to move
+  /// \param location The entities current location
+  /// \param target Archetype to move to, or nullptr to drop all components
+  /// \return The entities new row
+  size_t move_to(const Entity& entity, Location& location, Archetype* target)
+  {
+    auto& infos = component_infos();
+    auto* source = location.archetype;
+    size_t row = 0;
+
+    if ( target != nullptr ) {
+      row = target->push_row(entity);
+      for ( uint32_t id = 0; id < infos.size(); ++id ) {
+        if ( !target->has_column(id) )
+          continue;
+
+        if ( source != nullptr && source->has_column(id) )
+          infos[id].relocate(target->at(row, id), source->at(location.row, id));
+        else
+          infos[id].construct(target->at(row, id));
+      }
+    }
+
+    if ( source != nullptr ) {
+      for ( uint32_t id = 0; id < infos.size(); ++id ) {
+        if ( source->has_column(id) && (target == nullptr || !target->has_column(id)) )
+          infos[id].destroy(source->at(location.row, id));
+      }
+
+      Entity moved;
+      if ( source->pop_row(location.row, moved) )
+        locations_[moved.id].row = location.row;
+    }
+
+    location.archetype = target;
+    location.row = row;
+    return row;
   }
 
-private:
-  /// \brief Lookup array used to index into the actual data
-  Entity lookup_[UINT16_MAX];
+  /// \brief Calls fn for each row of a chunk with references into each column
+  template <typename Fn, typename... Ts>
+  static void each_in_chunk(Entity* entities, size_t rows, Fn& fn, Ts*... columns)
+  {
+    for ( size_t i = 0; i < rows; ++i )
+      fn(entities[i], columns[i]...);
+  }
 };
 
 /// \brief System is a base class for application systems operating
@@ -107,11 +1354,24 @@ private:
 /// entities from its ComponentData array.
 struct System {
 
+  /// \brief Destroys the system along with its component data
+  virtual ~System() = default;
+
   /// \brief Adds a new entity to this systems component data. Must be
   /// implemented by all derived classes
   /// \param entity Entity to add
   virtual void add(const Entity& entity) = 0;
 
+  /// \brief Adds a range of entities to the system. Systems should override
+  /// this to grow their storage once for the whole range
+  /// \param entities First entity to add
+  /// \param count Number of entities to add
+  virtual void add_many(const Entity* entities, size_t count)
+  {
+    for ( size_t i = 0; i < count; ++i )
+      add(entities[i]);
+  }
+
   /// \brief Removes an entity from this systems component data. Must be
   /// implemented by all derived classes
   /// \param entity Entity to remove
@@ -122,98 +1382,400 @@ struct System {
   /// \param entity Entity to check for
   /// \return True if has entity, false otherwise
   virtual bool has_entity(const Entity& entity) = 0;
+
+  /// \brief Declares the component types read and written by update() so the
+  /// EntityMap scheduler knows which systems can run at the same time. The
+  /// default declares no access, leaving the system unscheduled
+  /// \param access Access to add this systems component types to
+  virtual void declare_access(Access& /*access*/) {}
+
+  /// \brief Runs this systems per-frame logic. Called by the EntityMap
+  /// scheduler, possibly on a worker thread. The default does nothing
+  virtual void update() {}
+
+  /// \brief Gets the memory held by this systems component data. The default
+  /// reports nothing
+  /// \return The systems stats
+  virtual MemoryStats memory() const { return MemoryStats(); }
+
+  /// \brief Frees unused capacity in this systems component data. The
+  /// default does nothing
+  virtual void shrink_to_fit() {}
+
+  /// \brief Writes the systems components to a snapshot. Systems whose
+  /// components aren't trivially copyable, or can be rebuilt from other
+  /// systems, write nothing
+  /// \param writer Snapshot to write to
+  virtual void save(SnapshotWriter& /*writer*/) const {}
+
+  /// \brief Checks if save() writes the systems components. Systems that
+  /// don't have their entities added and removed on load so membership
+  /// matches the snapshot, with new entities getting fresh components
+  /// \return True if the system overrides save() and load()
+  virtual bool saves_components() const { return false; }
+
+  /// \brief Replaces the systems components with those written by save()
+  /// \param reader Snapshot to read from
+  virtual void load(SnapshotReader& /*reader*/) {}
 };
 
-/// \brief SpriteSystem operates on a set of sf::Sprite data, rendering them
-/// to an sf::RenderWindow
-struct SpriteSystem : public System {
+/// \brief Most System types a process can use, as each is given a bit in
+/// the 64 bit entity signatures
+constexpr uint32_t max_system_types = 64;
 
-  /// Sprite data to operate on
-  ComponentData<sf::Sprite> spriteData;
+static_assert(max_system_types <= sizeof(uint64_t) * 8,
+              "Every System type needs a bit in an entity signature");
 
-  /// \brief Adds a new entity to this systems component data.
-  /// \param entity Entity to add
-  inline void add(const Entity& entity) override
+/// \brief Gets the next unused system id
+/// \return The id
+inline uint32_t next_system_id()
+{
+  static uint32_t next = 0;
+  return next++;
+}
+
+/// \brief Gets a unique, densely packed id for a System type, used by
+/// EntityMap to find the System in a flat array rather than hashing its type.
+/// Ids are assigned in order of first use, starting at zero. The id space is
+/// global rather than per EntityMap: every System type used by any map in
+/// the process takes an id, so together they must number at most
+/// max_system_types, and a map sizes its system array by the largest id it
+/// uses
+/// \tparam Type of System to get the id for
+/// \return The System types id
+template <typename T>
+inline uint32_t system_id()
+{
+  static const uint32_t id = next_system_id();
+  assert(id < max_system_types && "Too many System types for a signature");
+  return id;
+}
+
+/// \brief Gets a bitmask with the bit of each System types id set, used to
+/// match entity signatures in EntityMap
+/// \tparam Ts System types to include
+/// \return The mask
+template <typename... Ts>
+inline uint64_t system_mask()
+{
+  uint64_t mask = 0;
+  for ( auto id : { uint32_t(0), (system_id<Ts>() + 1)... } ) {
+    if ( id > 0 )
+      mask |= uint64_t(1) << (id - 1);
+  }
+  return mask;
+}
+
+/// \brief SoaPointer stands in for a component pointer into structure of
+/// arrays storage, where no component object exists to point at. It gathers
+/// the component into a copy when created and scatters the copy back when
+/// destroyed, so it's used like the pointer ComponentData::get() returns
+/// within a single statement or scope. It can also wrap a real pointer, e.g.
+/// into archetype storage, in which case nothing is copied
+/// \tparam Storage SoA storage with value_type, gather(index) and
+/// scatter(index, value)
+template <typename Storage>
+class SoaPointer {
+public:
+  using value_type = typename Storage::value_type;
+
+  /// \brief Initializes a null pointer
+  SoaPointer() = default;
+
+  /// \brief Initializes a null pointer
+  SoaPointer(std::nullptr_t) {}
+
+  /// \brief Wraps a pointer to a real component
+  /// \param component Component to point at, may be nullptr
+  SoaPointer(value_type* component) : direct_(component) {}
+
+  /// \brief Gathers a component from storage
+  /// \param storage Storage holding the component
+  /// \param index Index of the component
+  SoaPointer(Storage* storage, size_t index)
+    : storage_(storage), index_(index), value_(storage->gather(index)) {}
+
+  SoaPointer(SoaPointer&& other)
+    : storage_(other.storage_), index_(other.index_), value_(other.value_),
+      direct_(other.direct_)
   {
-    spriteData.attach(entity);
+    other.storage_ = nullptr;
   }
 
-  /// \brief Removes an entity from this systems component data.
-  /// \param entity Entity to remove
-  inline void remove(const Entity& entity) override
+  SoaPointer(const SoaPointer&) = delete;
+  SoaPointer& operator=(const SoaPointer&) = delete;
+
+  /// \brief Scatters the component back into storage
+  ~SoaPointer()
   {
-    spriteData.detach(entity);
+    if ( storage_ )
+      storage_->scatter(index_, value_);
   }
 
-  /// \brief Checks if this system contains a specified entity
-  /// \param entity Entity to check for
-  /// \return True if has entity, false otherwise
-  inline bool has_entity(const Entity& entity) override
+  inline value_type* get() { return storage_ ? &value_ : direct_; }
+  inline value_type* operator->() { return get(); }
+  inline value_type& operator*() { return *get(); }
+  inline explicit operator bool() const { return storage_ || direct_; }
+  inline bool operator==(std::nullptr_t) const { return !*this; }
+  inline bool operator!=(std::nullptr_t) const { return !!*this; }
+
+private:
+  Storage* storage_ = nullptr;
+  size_t index_ = 0;
+  value_type value_ {};
+  value_type* direct_ = nullptr;
+};
+
+/// \brief Gets the component storage type of a System, which is its
+/// storage_type if it declares one and ComponentData of its component_type
+/// with the default allocator otherwise. Storage used by EntityMap::get() and
+/// View needs a pointer type, entities(), index_of(), touch(),
+/// component_at(index) returning a pointer, which SoA storage implements with
+/// SoaPointer, and parallel_ranges() splitting its indices into jobs
+template <typename S, typename = void>
+struct component_storage {
+  using type = ComponentData<typename S::component_type>;
+};
+
+template <typename S>
+struct component_storage<S, decltype(void(sizeof(typename S::storage_type)))> {
+  using type = typename S::storage_type;
+};
+
+/// \brief View is a join over the component data of several systems, visiting
+/// only the entities that have a component in every one of them
+/// \tparam Ts Types of System whose components are joined
+template <typename... Ts>
+class View {
+public:
+  /// \brief Initializes a view over resolved component data
+  /// \param data Component data of each system, in template order
+  /// \param archetypes Archetype storage to iterate instead, or nullptr
+  View(std::tuple<typename component_storage<Ts>::type*...> data,
+       ArchetypeStorage* archetypes)
+    : data_(data), archetypes_(archetypes) {}
+
+  /// \brief Calls a function for every entity with all of the views
+  /// components. Iteration is driven by the smallest component set and the
+  /// others are probed through their sparse index, so non-matching entities
+  /// cost one lookup per component. Components are passed mutably, so every
+  /// one visited is stamped as changed
+  /// \param fn Function called as fn(const Entity&, Ts::component_type&...)
+  template <typename Fn>
+  void each(Fn&& fn)
+  {
+    if ( archetypes_ ) {
+      archetypes_->each<typename Ts::component_type...>(fn);
+      return;
+    }
+
+    each_impl(fn, std::index_sequence_for<Ts...>());
+  }
+
+  /// \brief Calls a function for every entity with all of the views
+  /// components in parallel. The smallest component set is split into ranges
+  /// that each run as a job, starting on cache lines of the arrays its
+  /// storage writes so neighbouring jobs don't share a line of them
+  /// \param fn Function called as fn(const Entity&, Ts::component_type&...).
+  /// Must be safe to call concurrently for different entities
+  /// \param grain Target number of entities per job
+  /// \param pool Pool to run jobs on
+  template <typename Fn>
+  void parallel_each(Fn&& fn, size_t grain = 4096, JobPool& pool = JobPool::shared())
+  {
+    if ( archetypes_ ) {
+      archetypes_->parallel_each<typename Ts::component_type...>(fn, pool);
+      return;
+    }
+
+    auto seq = std::index_sequence_for<Ts...>();
+    auto smallest = driver(seq);
+    parallel_driver(seq, std::get<1>(smallest), grain, pool,
+      [&](size_t begin, size_t end) {
+        each_range(fn, seq, smallest, begin, end);
+      });
+  }
+
+  /// \brief Gets an upper bound on the number of entities visited by each
+  /// \return Size of the smallest component set
+  size_t size_hint() const
   {
-    return spriteData.has_component(entity);
+    return std::get<0>(driver(std::index_sequence_for<Ts...>()))->size();
   }
 
-  /// \brief Moves all sprites 1px down and to the right
-  void move()
+private:
+  /// \brief Component data of each joined system
+  std::tuple<typename component_storage<Ts>::type*...> data_;
+  /// \brief Archetype storage used in StorageMode::archetype
+  ArchetypeStorage* archetypes_;
+
+  /// \brief Finds the smallest of the joined component sets
+  /// \return The smallest dense entity array and its position in data_
+  template <size_t... Is>
+  std::tuple<const std::vector<Entity>*, size_t> driver(std::index_sequence<Is...>) const
   {
-    auto size = spriteData.instances.size();
-    for ( int e = 0; e < size; ++e ) {
-      spriteData.instances[e].move(1, 1);
+    const std::vector<Entity>* sets[] = { &std::get<Is>(data_)->entities()... };
+    size_t smallest = 0;
+    for ( size_t s = 1; s < sizeof...(Is); ++s ) {
+      if ( sets[s]->size() < sets[smallest]->size() )
+        smallest = s;
     }
+
+    return std::make_tuple(sets[smallest], smallest);
+  }
+
+  /// \brief Splits the driving storages indices into parallel ranges
+  template <typename Fn, size_t... Is>
+  void parallel_driver(std::index_sequence<Is...>, size_t d, size_t grain,
+                       JobPool& pool, Fn&& body)
+  {
+    int split[] = {
+      ((Is == d) ? (std::get<Is>(data_)->parallel_ranges(body, grain, pool), 0) : 0)...
+    };
+    (void)split;
   }
 
-  /// Renders all sprites to a window
-  /// \param window Widow to render to
-  void render(sf::RenderWindow &window)
+  template <typename Fn, size_t... Is>
+  void each_impl(Fn& fn, std::index_sequence<Is...> seq)
   {
-    auto size = spriteData.instances.size();
-    for ( int e = 0; e < size; ++e ) {
-      window.draw(spriteData.instances[e]);
+    auto smallest = driver(seq);
+    each_range(fn, seq, smallest, 0, std::get<0>(smallest)->size());
+  }
+
+  /// \brief Visits a range of the smallest component sets entities
+  template <typename Fn, size_t... Is>
+  void each_range(Fn& fn, std::index_sequence<Is...>,
+                  const std::tuple<const std::vector<Entity>*, size_t>& smallest,
+                  size_t begin, size_t end)
+  {
+    auto& entities = *std::get<0>(smallest);
+    auto d = std::get<1>(smallest);
+
+    for ( auto i = begin; i < end; ++i ) {
+      const auto& entity = entities[i];
+      EntityId indices[] = {
+        (Is == d) ? static_cast<EntityId>(i) : std::get<Is>(data_)->index_of(entity)...
+      };
+
+      bool matches = true;
+      for ( auto index : indices )
+        matches &= index != SparseSet::null_index;
+
+      if ( !matches )
+        continue;
+
+      // Components are handed out mutably, so each counts as changed
+      int stamped[] = { (std::get<Is>(data_)->touch(indices[Is]), 0)... };
+      (void)stamped;
+      fn(entity, *std::get<Is>(data_)->component_at(indices[Is])...);
     }
   }
+};
 
+/// \brief StorageMode selects where an EntityMap keeps component data
+enum class StorageMode {
+  /// Each System owns its components in a ComponentData array
+  component_data,
+  /// Components are grouped by entity in ArchetypeStorage chunks
+  archetype
 };
 
-/// \brief CollisionSystem is a placeholder for a collision checking system.
-// Currently it only reassigns a rectangle component
-struct CollisionSystem : public System {
+class EntityMap;
 
-  /// The collision boxes to operate on
-  ComponentData<sf::FloatRect> boxes;
+/// \brief CommandBuffer records structural changes - create, attach, remove
+/// and destroy - so they can be made while iterating or from worker threads
+/// and applied together at a sync point by EntityMap::flush(). A buffer must
+/// only be recorded to by one thread at a time
+class CommandBuffer {
+public:
+  /// \brief Generation given to placeholder entities returned by create()
+  static constexpr EntityId pending = std::numeric_limits<EntityId>::max();
 
-  /// \brief Adds a new entity to this systems component data.
-  /// \param entity Entity to add
-  inline void add(const Entity& entity) override
+  /// \brief Records creating an entity
+  /// \return Placeholder that can be passed to this buffers attach, remove
+  /// and destroy, and is replaced with the real entity on playback
+  inline Entity create()
   {
-    boxes.attach(entity);
+    Entity placeholder { creates_++, pending };
+    commands_.push_back(Command { Op::create, placeholder, nullptr });
+    return placeholder;
   }
 
-  /// \brief Removes an entity from this systems component data.
-  /// \param entity Entity to remove
-  inline void remove(const Entity& entity) override
+  /// \brief Records attaching an entity to a System
+  /// \tparam T Type of System to attach to
+  /// \param entity Entity or placeholder to attach
+  template <typename T>
+  inline void attach(const Entity& entity)
   {
-    boxes.detach(entity);
+    commands_.push_back(Command { Op::attach, entity, &apply_attach<T> });
   }
 
-  /// \brief Checks if this system contains a specified entity
-  /// \param entity Entity to check for
-  /// \return True if has entity, false otherwise
-  inline bool has_entity(const Entity& entity) override
+  /// \brief Records removing an entity from a System
+  /// \tparam T Type of System to remove from
+  /// \param entity Entity or placeholder to remove
+  template <typename T>
+  inline void remove(const Entity& entity)
   {
-    return boxes.has_component(entity);
+    commands_.push_back(Command { Op::remove, entity, &apply_remove<T> });
   }
 
-  /// \brief Reassigns each collision box to a new sf::FloatRect
-  void update_collision(const sf::FloatRect &rect)
+  /// \brief Records destroying an entity
+  /// \param entity Entity or placeholder to destroy
+  inline void destroy(const Entity& entity)
   {
-    auto size = boxes.instances.size();
-    bool intersect = false;
-
-    for ( int e = 0; e < size; ++e ) {
-      intersect = boxes.instances[e].intersects(rect);
-    }
+    commands_.push_back(Command { Op::destroy, entity, nullptr });
   }
 
+  /// \brief Gets the number of recorded commands
+  /// \return Number of commands
+  inline size_t size() const { return commands_.size(); }
+
+private:
+  friend class EntityMap;
+
+  /// \brief Kinds of command
+  enum class Op : uint8_t { create, attach, remove, destroy };
+
+  /// \brief A recorded command. Attach and remove store the function that
+  /// applies them to the recorded System type
+  struct Command {
+    Op op;
+    Entity entity;
+    void (*apply)(EntityMap&, const Entity&);
+  };
+
+  std::vector<Command> commands_;
+  /// \brief Number of placeholders handed out since the last playback
+  EntityId creates_ = 0;
+
+  template <typename T>
+  static void apply_attach(EntityMap& map, const Entity& entity);
+
+  template <typename T>
+  static void apply_remove(EntityMap& map, const Entity& entity);
+};
+
+/// \brief WorldStats describes the memory held by an EntityMap
+struct WorldStats {
+  /// Stats of each registered System, by name
+  std::vector<std::pair<std::string, MemoryStats>> systems;
+  /// Bytes of archetype chunks in StorageMode::archetype
+  size_t archetype_bytes = 0;
+  /// Bytes of generations, free ids and signatures
+  size_t entity_bytes = 0;
+  /// Number of tags, and how many refer to destroyed entities
+  size_t tags = 0;
+  size_t dead_tags = 0;
+
+  /// \brief Gets the total bytes allocated by systems, archetypes and entities
+  /// \return Total bytes, not counting tag strings
+  size_t total_bytes() const
+  {
+    auto total = archetype_bytes + entity_bytes;
+    for ( auto& system : systems )
+      total += system.second.total_bytes();
+    return total;
+  }
 };
 
 /// \brief EntityMap maps ComponentData, System, and Entity instances to one
@@ -223,26 +1785,209 @@ class EntityMap {
 public:
 
   /// \brief Initializes a new EntityMap
-  EntityMap() : nextId_(0), currentGeneration_(0), size_(0) {}
+  /// \param mode Where to store component data. In archetype mode attach,
+  /// remove and belongs_to operate on each Systems component_type inside
+  /// ArchetypeStorage rather than on the System's own ComponentData
+  explicit EntityMap(StorageMode mode = StorageMode::component_data)
+  {
+    if ( mode == StorageMode::archetype )
+      archetypes_.reset(new ArchetypeStorage);
+  }
 
-  /// \brief Registers a system to this EntityMap for convenient lookup
+  /// \brief Registers a system to this EntityMap for convenient lookup and
+  /// schedules its update() with the component access it declares. Systems
+  /// that declare no access aren't scheduled
   /// \tparam Type of System to add
+  /// \param name Name of the systems scheduled task, defaults to the type name
   /// \return Pointer to the System instance
   template <typename T>
-  inline T* add_system()
+  inline T* add_system(const std::string& name = typeid(T).name())
+  {
+    auto id = system_id<T>();
+    if ( id >= systems_.size() )
+      systems_.resize(id + 1);
+
+    auto inserted = !systems_[id];
+    if ( inserted )
+      systems_[id] = std::make_unique<T>();
+
+    auto* system = get_system<T>();
+
+    if ( inserted ) {
+      if ( id >= names_.size() )
+        names_.resize(id + 1);
+      names_[id] = name;
+
+      Access access;
+      system->declare_access(access);
+      if ( !access.empty() )
+        scheduler_.add(name, access, [system] { system->update(); });
+    }
+
+    return system;
+  }
+
+  /// \brief Runs every registered systems update() once, running systems
+  /// with non-conflicting component access in parallel, then plays back any
+  /// commands they recorded and resets the frame arenas
+  inline void update()
+  {
+    simulate();
+    sync();
+  }
+
+  /// \brief Runs every registered systems update() once without touching
+  /// entity structure, so it can overlap work that reads the structure, like
+  /// drawing last frames snapshot. Must be followed by sync()
+  inline void simulate()
+  {
+    scheduler_.run();
+  }
+
+  /// \brief The sync point after simulate(). Plays back recorded commands and
+  /// resets the frame arenas
+  inline void sync()
+  {
+    flush();
+
+    std::lock_guard<std::mutex> lock(arenasMutex_);
+    for ( auto& arena : arenas_ )
+      arena.second->reset();
+  }
+
+  /// \brief Gets the command buffer for the calling thread and the scheduled
+  /// task it's working for. Systems should record structural changes here
+  /// rather than make them while iterating. Look it up once per job rather
+  /// than per entity
+  /// \return The command buffer
+  CommandBuffer& commands()
+  {
+    std::lock_guard<std::mutex> lock(commandsMutex_);
+
+    auto task = Scheduler::current_task();
+    auto& buffer = commandBuffers_[std::make_pair(std::this_thread::get_id(), task)];
+    if ( !buffer ) {
+      buffer.reset(new CommandBuffer);
+      bufferOrder_.push_back(std::make_pair(task, buffer.get()));
+
+      // Commands recorded outside any task go first, then each tasks in the
+      // order the scheduler added them
+      std::stable_sort(bufferOrder_.begin(), bufferOrder_.end(),
+        [](const std::pair<size_t, CommandBuffer*>& a, const std::pair<size_t, CommandBuffer*>& b) {
+          return playback_rank(a.first) < playback_rank(b.first);
+        }
+      );
+    }
+    return *buffer;
+  }
+
+  /// \brief Gets the calling threads frame arena for scratch data that only
+  /// needs to live until the end of the frame. Every arena is reset at the
+  /// end of update(). Look it up once per job rather than per entity
+  /// \return The frame arena
+  FrameArena& frame_arena()
   {
-    systems_.emplace(typeid(T), std::make_unique<T>());
-    return get_system<T>();
+    std::lock_guard<std::mutex> lock(arenasMutex_);
+
+    auto& arena = arenas_[std::this_thread::get_id()];
+    if ( !arena )
+      arena.reset(new FrameArena);
+    return *arena;
+  }
+
+  /// \brief Plays back every recorded command as one batch. Buffers are
+  /// played back by the task that recorded them, in the order the scheduler
+  /// added the tasks, after commands recorded outside any task, so the result
+  /// doesn't depend on which threads ran which tasks. Buffers of one task
+  /// recorded by several of its jobs play back in the order the jobs first
+  /// asked for them, so such jobs should only record commands whose relative
+  /// order doesn't matter. Every create runs first so placeholders can be
+  /// resolved. The rest are
+  /// ordered by entity id so storage is swept in one pass, keeping the order
+  /// each entities commands were recorded in, so remove then attach resets a
+  /// component. Commands for entities destroyed in the meantime are skipped.
+  /// Must be called while no system is running
+  void flush()
+  {
+    std::lock_guard<std::mutex> lock(commandsMutex_);
+
+    playback_.clear();
+    for ( auto& entry : bufferOrder_ ) {
+      auto& buffer = *entry.second;
+      if ( buffer.commands_.empty() )
+        continue;
+
+      // Creates are resolved in recorded order so placeholders can be
+      // replaced before sorting
+      created_.clear();
+      for ( auto& command : buffer.commands_ ) {
+        if ( command.op == CommandBuffer::Op::create )
+          created_.push_back(create());
+      }
+
+      for ( auto& command : buffer.commands_ ) {
+        if ( command.op == CommandBuffer::Op::create )
+          continue;
+
+        if ( command.entity.generation == CommandBuffer::pending )
+          command.entity = created_[command.entity.id];
+        playback_.push_back(command);
+      }
+
+      buffer.commands_.clear();
+      buffer.creates_ = 0;
+    }
+
+    std::stable_sort(playback_.begin(), playback_.end(),
+      [](const CommandBuffer::Command& a, const CommandBuffer::Command& b) {
+        return a.entity.id < b.entity.id;
+      }
+    );
+
+    for ( auto& command : playback_ ) {
+      if ( command.op == CommandBuffer::Op::destroy )
+        destroy(command.entity);
+      else if ( is_alive(command.entity) )
+        command.apply(*this, command.entity);
+    }
   }
 
+  /// \brief Gets the scheduler running system updates, e.g. to add extra
+  /// tasks or switch to serial execution for debugging
+  /// \return The scheduler
+  inline Scheduler& scheduler() { return scheduler_; }
+
   /// \brief Creates a new Entity
   /// \return The new entity
   inline Entity create()
   {
-    size_++;
     return get_entity();
   }
 
+  /// \brief Creates several entities at once, reusing destroyed ids first
+  /// and growing the generation table once for the rest
+  /// \param count Number of entities to create
+  /// \return The new entities
+  std::vector<Entity> create_many(size_t count)
+  {
+    std::vector<Entity> entities(count);
+
+    auto reused = std::min(count, freeIds_.size());
+    for ( size_t i = 0; i < reused; ++i ) {
+      auto id = freeIds_[freeIds_.size() - 1 - i];
+      entities[i] = Entity { id, generations_[id] };
+    }
+    freeIds_.resize(freeIds_.size() - reused);
+
+    auto first = generations_.size();
+    generations_.resize(first + count - reused, 0);
+    signatures_.resize(generations_.size(), 0);
+    for ( auto i = reused; i < count; ++i )
+      entities[i] = Entity { static_cast<EntityId>(first + i - reused), 0 };
+
+    return entities;
+  }
+
   /// \brief Creates a new Entity with the specified tag
   /// \return The new entity
   inline Entity create(const std::string& tag)
@@ -252,40 +1997,163 @@ public:
     return e;
   }
 
-  /// \brief Destroys an entity by removing it from all registered System instances
+  /// \brief Destroys an entity by removing it from the System instances its
+  /// signature says it belongs to and returning its id to the free list. Does nothing if the
+  /// entity has already been destroyed
   /// \param entity Entity to remove
   void destroy(const Entity &entity)
   {
-    size_--;
-    for ( auto &s : systems_ ) {
-      s.second->remove(entity);
+    if ( !is_alive(entity) )
+      return;
+
+    if ( archetypes_ ) {
+      archetypes_->destroy(entity);
+    } else {
+      // Only visit the systems the entity was attached to
+      auto signature = signatures_[entity.id];
+      while ( signature != 0 ) {
+        systems_[__builtin_ctzll(signature)]->remove(entity);
+        signature &= signature - 1;
+      }
     }
+
+    signatures_[entity.id] = 0;
+    generations_[entity.id]++;
+    freeIds_.push_back(entity.id);
+  }
+
+  /// \brief Checks if an entity handle still refers to a living entity
+  /// \param entity Entity to check
+  /// \return True if the entity hasn't been destroyed, false otherwise
+  inline bool is_alive(const Entity& entity) const
+  {
+    return entity.id < generations_.size()
+      && generations_[entity.id] == entity.generation;
   }
 
   /// \brief Gets a tagged entity
   /// \param tag Tag to search for
-  /// \return The entity
-  Entity get_tagged_entity(const std::string& tag)
+  /// \return The entity, or one that is_alive() rejects if no entity has the
+  /// tag, including when the tag was dropped by shrink_to_fit()
+  Entity get_tagged_entity(const std::string& tag) const
   {
-    return tags_[tag];
+    auto found = tags_.find(tag);
+    if ( found == tags_.end() )
+      return Entity { SparseSet::null_index, SparseSet::null_index };
+
+    return found->second;
   }
 
-  /// \brief Attaches an Entity to the specified System instance
+  /// \brief Attaches an Entity to the specified System instance. Does nothing
+  /// if the entity is dead or already attached
   /// \tparam Type of System to attach to
   /// \param entity Entity to attach
   template <typename T>
   inline void attach(const Entity &entity)
   {
-    systems_[typeid(T)]->add(entity);
+    auto bit = uint64_t(1) << system_id<T>();
+    if ( !is_alive(entity) || (signatures_[entity.id] & bit) != 0 )
+      return;
+
+    signatures_[entity.id] |= bit;
+
+    if ( archetypes_ ) {
+      archetypes_->add<typename T::component_type>(entity);
+      return;
+    }
+
+    system_for<T>()->T::add(entity);
+  }
+
+  /// \brief Attaches a range of entities to the specified System instance
+  /// with a single lookup and batched construction. Entities that are dead
+  /// or already attached, including repeats within the range, are skipped
+  /// \tparam Type of System to attach to
+  /// \param entities First entity to attach
+  /// \param count Number of entities to attach
+  template <typename T>
+  inline void attach(const Entity* entities, size_t count)
+  {
+    auto bit = uint64_t(1) << system_id<T>();
+    size_t i = 0;
+    for ( ; i < count; ++i ) {
+      if ( !is_alive(entities[i]) || (signatures_[entities[i].id] & bit) != 0 )
+        break;
+      signatures_[entities[i].id] |= bit;
+    }
+
+    // Only copy the range if some of it has to be filtered out
+    if ( i < count ) {
+      attaching_.assign(entities, entities + i);
+      for ( ; i < count; ++i ) {
+        if ( !is_alive(entities[i]) || (signatures_[entities[i].id] & bit) != 0 )
+          continue;
+        signatures_[entities[i].id] |= bit;
+        attaching_.push_back(entities[i]);
+      }
+
+      entities = attaching_.data();
+      count = attaching_.size();
+    }
+
+    if ( archetypes_ ) {
+      for ( size_t i = 0; i < count; ++i )
+        archetypes_->add<typename T::component_type>(entities[i]);
+      return;
+    }
+
+    system_for<T>()->T::add_many(entities, count);
+  }
+
+  /// \brief Attaches every entity in a vector to the specified System instance
+  /// \tparam Type of System to attach to
+  /// \param entities Entities to attach
+  template <typename T>
+  inline void attach(const std::vector<Entity>& entities)
+  {
+    attach<T>(entities.data(), entities.size());
   }
 
-  /// \brief Removes an Entity from the specified System instance
+  /// \brief Removes an Entity from the specified System instance. Does nothing
+  /// if the entity is dead or isn't attached
   /// \tparam Type of System to remove from
   /// \param entity Entity to remove
   template <typename T>
   inline void remove(const Entity& entity)
   {
-    systems_[typeid(T)]->remove(entity);
+    auto bit = uint64_t(1) << system_id<T>();
+    if ( !is_alive(entity) || (signatures_[entity.id] & bit) == 0 )
+      return;
+
+    signatures_[entity.id] &= ~bit;
+
+    if ( archetypes_ ) {
+      archetypes_->remove<typename T::component_type>(entity);
+      return;
+    }
+
+    system_for<T>()->T::remove(entity);
+  }
+
+  /// \brief Gets an entities component for the specified System regardless
+  /// of storage mode
+  /// \tparam Type of System whose component to get
+  /// \param entity Entity whose component is being retrieved
+  /// \return Pointer to the component if found, nullptr otherwise
+  template <typename T>
+  inline typename component_storage<T>::type::pointer get(const Entity& entity)
+  {
+    if ( archetypes_ )
+      return archetypes_->get<typename T::component_type>(entity);
+
+    // Handing out a mutable component counts as a change
+    auto& storage = get_system<T>()->components();
+    auto index = storage.index_of(entity);
+    if ( index == SparseSet::null_index )
+      return nullptr;
+
+    storage.touch(index);
+    return storage.component_at(index);
   }
 
   /// \brief Gets a pointer to the specified registered System instance
@@ -294,52 +2162,313 @@ public:
   template <typename T>
   inline T* get_system()
   {
-    return static_cast<T*>(systems_[typeid(T)].get());
+    auto id = system_id<T>();
+    return id < systems_.size() ? static_cast<T*>(systems_[id].get()) : nullptr;
   }
 
   /// \brief Checks if an entity belongs to a specific system
   /// \param entity Entity to check
   /// \return True if belongs to system, false otherwise
   template<typename T>
-  inline bool belongs_to(const Entity& entity)
+  inline bool belongs_to(const Entity& entity) const
+  {
+    return matches(entity, system_mask<T>());
+  }
+
+  /// \brief Checks if an entity belongs to every system in a mask
+  /// \param entity Entity to check
+  /// \param mask Mask from system_mask()
+  /// \return True if the entity is alive and belongs to all of them
+  inline bool matches(const Entity& entity, uint64_t mask) const
+  {
+    return is_alive(entity) && (signatures_[entity.id] & mask) == mask;
+  }
+
+  /// \brief Gets the systems an entity belongs to
+  /// \param entity Entity to get the signature of
+  /// \return Bitmask of the system_id() of each System the entity belongs
+  /// to, or 0 if it's dead
+  inline uint64_t signature(const Entity& entity) const
+  {
+    return is_alive(entity) ? signatures_[entity.id] : 0;
+  }
+
+  /// \brief Creates a view joining the components of several systems. The
+  /// systems are resolved once here rather than per entity
+  /// \tparam Ts Types of System to join
+  /// \return The view
+  template <typename... Ts>
+  inline View<Ts...> view()
+  {
+    if ( archetypes_ ) {
+      return View<Ts...>(
+        std::make_tuple(
+          static_cast<typename component_storage<Ts>::type*>(nullptr)...
+        ),
+        archetypes_.get()
+      );
+    }
+
+    return View<Ts...>(
+      std::make_tuple(&get_system<Ts>()->components()...), nullptr
+    );
+  }
+
+  /// \brief Calls a function for every entity that belongs to all of the
+  /// specified systems
+  /// \tparam Ts Types of System to join
+  /// \param fn Function called as fn(const Entity&, Ts::component_type&...)
+  template <typename... Ts, typename Fn>
+  inline void each(Fn&& fn)
+  {
+    view<Ts...>().each(std::forward<Fn>(fn));
+  }
+
+  /// \brief Gets the memory held by every system, the archetype storage and
+  /// the entity tables
+  /// \return The stats
+  WorldStats memory() const
+  {
+    WorldStats stats;
+    for ( size_t id = 0; id < systems_.size(); ++id ) {
+      if ( systems_[id] )
+        stats.systems.emplace_back(names_[id], systems_[id]->memory());
+    }
+
+    if ( archetypes_ ) {
+      for ( auto& archetype : archetypes_->archetypes() )
+        stats.archetype_bytes += archetype.second->reserved_bytes();
+    }
+
+    stats.entity_bytes = generations_.capacity() * sizeof(EntityId)
+      + freeIds_.capacity() * sizeof(EntityId)
+      + signatures_.capacity() * sizeof(uint64_t);
+
+    stats.tags = tags_.size();
+    for ( auto& tag : tags_ )
+      stats.dead_tags += is_alive(tag.second) ? 0 : 1;
+
+    return stats;
+  }
+
+  /// \brief Frees unused capacity in every system, the entity tables and
+  /// command playback scratch space, and drops tags of destroyed entities
+  void shrink_to_fit()
   {
-    return systems_[typeid(T)]->has_entity(entity);
+    for ( auto& system : systems_ ) {
+      if ( system )
+        system->shrink_to_fit();
+    }
+
+    for ( auto tag = tags_.begin(); tag != tags_.end(); ) {
+      if ( is_alive(tag->second) )
+        ++tag;
+      else
+        tag = tags_.erase(tag);
+    }
+
+    generations_.shrink_to_fit();
+    freeIds_.shrink_to_fit();
+    signatures_.shrink_to_fit();
+    playback_.shrink_to_fit();
+    created_.shrink_to_fit();
+    attaching_.shrink_to_fit();
+  }
+
+  /// \brief Copies the entity tables and every systems components into a
+  /// snapshot, for rollback or replay. Take snapshots between frames, after
+  /// sync(), as pending commands aren't saved. Tags and archetype storage
+  /// aren't saved either. Systems that write nothing keep the components of
+  /// entities that exist in both states on load(), lose those of entities
+  /// that don't and give fresh components to entities only in the snapshot
+  /// \param writer Snapshot to write to
+  void save(SnapshotWriter& writer) const
+  {
+    writer.write_array(generations_);
+    writer.write_array(signatures_);
+    writer.write_array(freeIds_);
+
+    for ( auto& system : systems_ ) {
+      if ( system )
+        system->save(writer);
+    }
+  }
+
+  /// \brief Copies the entity tables and every systems components into a
+  /// snapshot
+  /// \param snapshot Snapshot to overwrite, its storage is reused
+  inline void save(Snapshot& snapshot) const
+  {
+    SnapshotWriter writer(snapshot);
+    save(writer);
+  }
+
+  /// \brief Restores the state from save(). The same systems must have been
+  /// added in the same order as when the snapshot was taken
+  /// \param snapshot Snapshot to restore
+  void load(const Snapshot& snapshot)
+  {
+    // Systems that aren't saved still hold components for the current
+    // entities, which have to be matched up with the restored ones
+    uint64_t unsaved = 0;
+    if ( !archetypes_ ) {
+      for ( size_t id = 0; id < systems_.size(); ++id ) {
+        if ( systems_[id] && !systems_[id]->saves_components() )
+          unsaved |= uint64_t(1) << id;
+      }
+    }
+
+    if ( unsaved != 0 ) {
+      loadGenerations_.assign(generations_.begin(), generations_.end());
+      loadSignatures_.assign(signatures_.begin(), signatures_.end());
+    }
+
+    SnapshotReader reader(snapshot);
+    reader.read_array(generations_);
+    reader.read_array(signatures_);
+    reader.read_array(freeIds_);
+
+    for ( auto& system : systems_ ) {
+      if ( system )
+        system->load(reader);
+    }
+
+    if ( unsaved != 0 )
+      reload_unsaved(unsaved);
   }
 
+  /// \brief Gets the archetype storage used in StorageMode::archetype
+  /// \return Pointer to the storage, or nullptr in component data mode
+  inline ArchetypeStorage* archetypes() { return archetypes_.get(); }
+
   /// \brief Gets the number of Entity instances currently alive
   /// \return Number of alive Entity instances
-  inline uint64_t size() { return size_; }
+  inline uint64_t size() { return generations_.size() - freeIds_.size(); }
 
 private:
-  /// \brief Map for lookup and retrieval of stored System instances
-  std::unordered_map<std::type_index, std::unique_ptr<System>> systems_;
+  /// \brief Registered System instances, indexed by system_id()
+  std::vector<std::unique_ptr<System>> systems_;
+  /// \brief Name each System was added with, indexed by system_id()
+  std::vector<std::string> names_;
   /// \brief All tagged entities
   std::unordered_map<std::string, Entity> tags_;
-  /// \brief The next available unique ID for assigning to Entity instances
-  uint16_t nextId_;
-  /// \brief The current generation of entity id's
-  uint16_t currentGeneration_;
-  /// \brief The number of currently living entities
-  uint64_t size_;
-
-  /// \brief Gets the next available Entity with id and generation
-  /// \return
-  inline Entity get_entity() {
-    nextId_++;
+  /// \brief Component storage used in StorageMode::archetype
+  std::unique_ptr<ArchetypeStorage> archetypes_;
+  /// \brief Runs registered system updates each frame
+  Scheduler scheduler_;
+  /// \brief The current generation of every entity id ever handed out. Like
+  /// signatures_ and freeIds_ it uses the default allocator, as allocator
+  /// policies only apply to ComponentData instances
+  std::vector<EntityId> generations_;
+  /// \brief Bitmask of the systems each entity id belongs to, indexed by id.
+  /// Limits the process to max_system_types System types
+  std::vector<uint64_t> signatures_;
+  /// \brief Ids of destroyed entities available for reuse
+  std::vector<EntityId> freeIds_;
+  /// \brief Guards commandBuffers_
+  std::mutex commandsMutex_;
+  /// \brief Command buffer of each thread and task pair that has recorded
+  /// commands
+  std::map<std::pair<std::thread::id, size_t>, std::unique_ptr<CommandBuffer>> commandBuffers_;
+  /// \brief Command buffers and their recording task, in playback order
+  std::vector<std::pair<size_t, CommandBuffer*>> bufferOrder_;
+
+  /// \brief Gets where a tasks commands play back relative to other tasks
+  /// \param task Index of the task, or JobPool::no_context
+  /// \return Rank, with commands recorded outside any task first
+  static inline size_t playback_rank(size_t task)
+  {
+    return task == JobPool::no_context ? 0 : task + 1;
+  }
+  /// \brief Guards arenas_
+  std::mutex arenasMutex_;
+  /// \brief Frame arena of each thread that has asked for one
+  std::unordered_map<std::thread::id, std::unique_ptr<FrameArena>> arenas_;
+  /// \brief Scratch space for flush(), kept to avoid reallocating each frame
+  std::vector<CommandBuffer::Command> playback_;
+  std::vector<Entity> created_;
+  /// \brief Scratch space for range attach(), holding the entities left
+  /// after filtering
+  std::vector<Entity> attaching_;
+  /// \brief Scratch space for load(), holding the tables being replaced
+  std::vector<EntityId> loadGenerations_;
+  std::vector<uint64_t> loadSignatures_;
+
+  /// \brief Removes entities from systems that aren't saved if they aren't
+  /// in them in the restored state, and adds the ones that are. Entities
+  /// whose id was reused in between are treated as different entities, so
+  /// no component is handed to the wrong one
+  /// \param unsaved Bitmask of the system ids to update
+  void reload_unsaved(uint64_t unsaved)
+  {
+    auto ids = std::max(loadGenerations_.size(), generations_.size());
+    for ( size_t id = 0; id < ids; ++id ) {
+      auto before = id < loadSignatures_.size() ? loadSignatures_[id] & unsaved : 0;
+      auto after = id < signatures_.size() ? signatures_[id] & unsaved : 0;
+
+      // Signatures are only set for living entities
+      auto same = before != 0 && after != 0
+        && loadGenerations_[id] == generations_[id];
+      auto left = same ? before & ~after : before;
+      auto joined = same ? after & ~before : after;
+
+      while ( left != 0 ) {
+        auto entity = Entity { static_cast<EntityId>(id), loadGenerations_[id] };
+        systems_[__builtin_ctzll(left)]->remove(entity);
+        left &= left - 1;
+      }
+
+      while ( joined != 0 ) {
+        auto entity = Entity { static_cast<EntityId>(id), generations_[id] };
+        systems_[__builtin_ctzll(joined)]->add(entity);
+        joined &= joined - 1;
+      }
+    }
+  }
 
-    // Check for next generation
-    if ( nextId_ == 0 )
-      currentGeneration_++;
+  /// \brief Gets a registered System for a per-entity operation. Callers
+  /// make qualified T:: calls on it so they're bound statically rather than
+  /// through the vtable
+  /// \tparam Type of System to get, which must have been added
+  /// \return Pointer to the System
+  template <typename T>
+  inline T* system_for()
+  {
+    return static_cast<T*>(systems_[system_id<T>()].get());
+  }
 
+  /// \brief Gets the next available Entity with id and generation, reusing a
+  /// destroyed entities id if one is available
+  /// \return The new entity
+  inline Entity get_entity() {
     Entity e;
-    e.id = nextId_;
-    e.index = UINT16_MAX;
-    e.generation = currentGeneration_;
 
+    if ( freeIds_.empty() ) {
+      e.id = static_cast<EntityId>(generations_.size());
+      generations_.push_back(0);
+      signatures_.push_back(0);
+    } else {
+      e.id = freeIds_.back();
+      freeIds_.pop_back();
+    }
+
+    e.generation = generations_[e.id];
     return e;
   }
 };
 
+template <typename T>
+void CommandBuffer::apply_attach(EntityMap& map, const Entity& entity)
+{
+  map.attach<T>(entity);
+}
+
+template <typename T>
+void CommandBuffer::apply_remove(EntityMap& map, const Entity& entity)
+{
+  map.remove<T>(entity);
+}
+
 }
 
 #endif //ECS_FRAMEWORK_COMPONENTDATA_HPP
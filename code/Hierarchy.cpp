@@ -0,0 +1,200 @@
+//
+// Hierarchy.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "Hierarchy.hpp"
+
+#include <algorithm>
+
+namespace ecs {
+
+void HierarchySystem::set_parent(const Entity& entity, const Entity& parent)
+{
+  auto node = nodes.get(entity);
+  if ( node == nullptr )
+    return;
+
+  node->parent = parent;
+  dirty_ = true;
+}
+
+void HierarchySystem::set_local(const Entity& entity, const sf::Vector2f& position,
+                                const sf::Vector2f& scale)
+{
+  auto node = nodes.get(entity);
+  if ( node == nullptr )
+    return;
+
+  node->position = position;
+  node->scale = scale;
+}
+
+void HierarchySystem::update()
+{
+  if ( dirty_ )
+    rebuild();
+
+  auto& instances = nodes.instances;
+
+  // Roots take their local transform as is
+  parallel_for(world_x.data(), levels_[1], 4096, [&](size_t begin, size_t end) {
+    for ( auto s = begin; s < end; ++s ) {
+      auto& node = instances[s];
+      world_x[s] = node.position.x;
+      world_y[s] = node.position.y;
+      world_sx[s] = node.scale.x;
+      world_sy[s] = node.scale.y;
+    }
+  });
+
+  // Every parent is in an earlier level, so each level only reads finished
+  // results and its slots can be computed in any order
+  for ( size_t level = 1; level + 1 < levels_.size(); ++level ) {
+    auto first = levels_[level];
+    auto count = levels_[level + 1] - first;
+    parallel_for(world_x.data() + first, count, 4096, [&](size_t begin, size_t end) {
+      for ( auto s = first + begin; s < first + end; ++s ) {
+        auto& node = instances[s];
+        auto p = parents_[s];
+        world_x[s] = world_x[p] + node.position.x * world_sx[p];
+        world_y[s] = world_y[p] + node.position.y * world_sy[p];
+        world_sx[s] = world_sx[p] * node.scale.x;
+        world_sy[s] = world_sy[p] * node.scale.y;
+      }
+    });
+  }
+}
+
+sf::Vector2f HierarchySystem::world_position(const Entity& entity) const
+{
+  auto s = world_index(entity);
+  if ( s == SparseSet::null_index )
+    return sf::Vector2f();
+
+  return sf::Vector2f(world_x[s], world_y[s]);
+}
+
+EntityId HierarchySystem::world_index(const Entity& entity) const
+{
+  auto index = nodes.index_of(entity);
+  if ( index == SparseSet::null_index || index >= world_x.size() || dirty_ )
+    return SparseSet::null_index;
+
+  return index;
+}
+
+MemoryStats HierarchySystem::memory() const
+{
+  auto stats = nodes.memory();
+  stats.index_bytes += (world_x.capacity() + world_y.capacity()
+    + world_sx.capacity() + world_sy.capacity()) * sizeof(float)
+    + (order_.capacity() + slot_.capacity() + parents_.capacity()
+    + depths_.capacity()) * sizeof(EntityId)
+    + levels_.capacity() * sizeof(size_t);
+  return stats;
+}
+
+void HierarchySystem::shrink_to_fit()
+{
+  nodes.shrink_to_fit();
+  world_x.shrink_to_fit();
+  world_y.shrink_to_fit();
+  world_sx.shrink_to_fit();
+  world_sy.shrink_to_fit();
+  order_.shrink_to_fit();
+  slot_.shrink_to_fit();
+  parents_.shrink_to_fit();
+  depths_.shrink_to_fit();
+  levels_.shrink_to_fit();
+}
+
+void HierarchySystem::rebuild()
+{
+  auto& instances = nodes.instances;
+  auto count = instances.size();
+  const auto unknown = SparseSet::null_index;
+
+  // Resolve each nodes parent to an index, treating parents outside the
+  // hierarchy as making the node a root
+  parents_.resize(count);
+  for ( size_t i = 0; i < count; ++i )
+    parents_[i] = nodes.index_of(instances[i].parent);
+
+  // Find each nodes depth by walking up to the first node with a known depth,
+  // then filling in the path on the way back down. Nodes on the current walk
+  // are marked so reaching one again finds a cycle
+  const auto visiting = unknown - 1;
+  depths_.assign(count, unknown);
+  std::vector<EntityId> path;
+  for ( size_t i = 0; i < count; ++i ) {
+    auto node = static_cast<EntityId>(i);
+    path.clear();
+    while ( node != unknown && depths_[node] == unknown ) {
+      depths_[node] = visiting;
+      path.push_back(node);
+      node = parents_[node];
+    }
+
+    // The cycle is broken by making the repeated node a root. The nodes after
+    // it on the path are its ancestors in the cycle, and are left for a later
+    // walk that will find it
+    if ( node != unknown && depths_[node] == visiting ) {
+      parents_[node] = unknown;
+      auto cut = std::find(path.begin(), path.end(), node) + 1;
+      for ( auto it = cut; it != path.end(); ++it )
+        depths_[*it] = unknown;
+      path.erase(cut, path.end());
+      node = unknown;
+    }
+
+    auto depth = (node == unknown) ? EntityId(0) : depths_[node] + 1;
+    for ( auto n = path.size(); n > 0; --n )
+      depths_[path[n - 1]] = depth++;
+  }
+
+  // Counting sort by depth so parents always precede their children
+  levels_.assign(1, 0);
+  for ( size_t i = 0; i < count; ++i ) {
+    if ( depths_[i] + 2 > levels_.size() )
+      levels_.resize(depths_[i] + 2, 0);
+    levels_[depths_[i] + 1]++;
+  }
+  if ( levels_.size() < 2 )
+    levels_.resize(2, 0);
+  for ( size_t level = 1; level < levels_.size(); ++level )
+    levels_[level] += levels_[level - 1];
+
+  order_.resize(count);
+  slot_.resize(count);
+  auto next = levels_;
+  for ( size_t i = 0; i < count; ++i ) {
+    auto s = next[depths_[i]]++;
+    order_[s] = static_cast<EntityId>(i);
+    slot_[i] = static_cast<EntityId>(s);
+  }
+
+  // Move the nodes themselves into depth order, so update() reads them and
+  // their parents by slot without gathering through an index
+  std::vector<EntityId> slotParents(count, unknown);
+  for ( size_t s = 0; s < count; ++s ) {
+    auto parent = parents_[order_[s]];
+    if ( parent != unknown )
+      slotParents[s] = slot_[parent];
+  }
+  parents_.swap(slotParents);
+  nodes.permute(order_);
+
+  world_x.resize(count);
+  world_y.resize(count);
+  world_sx.resize(count);
+  world_sy.resize(count);
+  dirty_ = false;
+}
+
+}
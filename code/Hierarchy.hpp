@@ -0,0 +1,184 @@
+//
+// Hierarchy.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_HIERARCHY_HPP
+#define ECS_FRAMEWORK_HIERARCHY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Entity.hpp"
+
+namespace ecs {
+
+/// \brief HierarchyNode is an entities transform relative to its parent
+struct HierarchyNode {
+  /// Parent entity, or an entity outside the hierarchy for a root
+  Entity parent { SparseSet::null_index, SparseSet::null_index };
+  /// Position relative to the parent, scaled by the parents world scale
+  sf::Vector2f position;
+  /// Scale relative to the parent
+  sf::Vector2f scale { 1, 1 };
+};
+
+/// \brief HierarchySystem computes world transforms for a hierarchy of
+/// entities. The nodes themselves are permuted into depth order, so every
+/// parent comes before its children, each depth is a contiguous level and a
+/// nodes index is also the index of its world transform.
+/// update() walks the levels in order, computing each level in parallel
+/// from the finished level above it, so no pointers are chased and every
+/// pass streams linearly through memory. The layout is only rebuilt when
+/// nodes are added, removed or re-parented
+struct HierarchySystem : public System {
+
+  /// Type of component this system operates on
+  using component_type = HierarchyNode;
+
+  /// Local transform and parent of each node, in depth order as of the last
+  /// update. Nodes added since are appended in attach order
+  ComponentData<HierarchyNode> nodes;
+
+  /// World x coordinate of each node, indexed like nodes
+  AlignedVector<float> world_x;
+  /// World y coordinate of each node, indexed like nodes
+  AlignedVector<float> world_y;
+  /// World x scale of each node, indexed like nodes
+  AlignedVector<float> world_sx;
+  /// World y scale of each node, indexed like nodes
+  AlignedVector<float> world_sy;
+
+  /// \brief Gets the component data this system operates on
+  /// \return The nodes
+  inline ComponentData<HierarchyNode>& components() { return nodes; }
+
+  /// \brief Adds a new entity as a root node
+  /// \param entity Entity to add
+  inline void add(const Entity& entity) override
+  {
+    nodes.attach(entity);
+    dirty_ = true;
+  }
+
+  /// \brief Adds a range of entities as root nodes
+  /// \param entities First entity to add
+  /// \param count Number of entities to add
+  inline void add_many(const Entity* entities, size_t count) override
+  {
+    nodes.attach(entities, count);
+    dirty_ = true;
+  }
+
+  /// \brief Removes an entity from the hierarchy. Its children become roots
+  /// \param entity Entity to remove
+  inline void remove(const Entity& entity) override
+  {
+    nodes.detach(entity);
+    dirty_ = true;
+  }
+
+  /// \brief Checks if this system contains a specified entity
+  /// \param entity Entity to check for
+  /// \return True if has entity, false otherwise
+  inline bool has_entity(const Entity& entity) override
+  {
+    return nodes.has_component(entity);
+  }
+
+  /// \brief Declares write access to hierarchy nodes for update()
+  /// \param access Access to add HierarchyNode to
+  inline void declare_access(Access& access) override
+  {
+    access.writes |= component_mask<HierarchyNode>();
+  }
+
+  /// \brief Gets the memory held by the nodes, counting the world arrays and
+  /// depth ordering as index storage
+  /// \return The hierarchy stats
+  MemoryStats memory() const override;
+
+  /// \brief Frees unused capacity in the nodes, world arrays and ordering
+  void shrink_to_fit() override;
+
+  /// \brief Writes the nodes to a snapshot. World transforms are recomputed
+  /// \param writer Snapshot to write to
+  inline void save(SnapshotWriter& writer) const override { nodes.save(writer); }
+
+  /// \brief Checks if save() writes the systems components
+  /// \return Always true
+  inline bool saves_components() const override { return true; }
+
+  /// \brief Restores the nodes from a snapshot, rebuilding the depth order
+  /// on the next update
+  /// \param reader Snapshot to read from
+  inline void load(SnapshotReader& reader) override
+  {
+    nodes.load(reader);
+    dirty_ = true;
+  }
+
+  /// \brief Changes a nodes parent. Does nothing if the entity has no node
+  /// \param entity Entity to re-parent
+  /// \param parent New parent, or an entity outside the hierarchy to make
+  /// the node a root
+  void set_parent(const Entity& entity, const Entity& parent);
+
+  /// \brief Sets a nodes position and scale relative to its parent
+  /// \param entity Entity to update
+  /// \param position New local position
+  /// \param scale New local scale
+  void set_local(const Entity& entity, const sf::Vector2f& position,
+                 const sf::Vector2f& scale = sf::Vector2f(1, 1));
+
+  /// \brief Computes the world transform of every node
+  void update() override;
+
+  /// \brief Gets a nodes world position from the last update
+  /// \param entity Entity to look up
+  /// \return The world position, or zero if the entity has no node or was
+  /// added since the last update
+  sf::Vector2f world_position(const Entity& entity) const;
+
+  /// \brief Gets the index of a nodes world transform in the world arrays
+  /// \param entity Entity to look up
+  /// \return The index, or SparseSet::null_index if the entity has no node or
+  /// was added since the last update
+  EntityId world_index(const Entity& entity) const;
+
+  /// \brief Gets the number of levels in the hierarchy
+  /// \return The depth of the deepest node plus one
+  inline size_t depth() const
+  {
+    return levels_.empty() ? 0 : levels_.size() - 1;
+  }
+
+private:
+  /// \brief Scratch index of the node moving to each slot, used by rebuild()
+  std::vector<EntityId> order_;
+  /// \brief Scratch slot each node moves to, used by rebuild()
+  std::vector<EntityId> slot_;
+  /// \brief Index of each nodes parent, or SparseSet::null_index for roots
+  std::vector<EntityId> parents_;
+  /// \brief First slot of each level, with a final end offset
+  std::vector<size_t> levels_;
+  /// \brief Scratch depth of each node used by rebuild()
+  std::vector<EntityId> depths_;
+  /// \brief Set when the layout needs rebuilding
+  bool dirty_ = true;
+
+  /// \brief Permutes nodes into depth order and rebuilds the parent links
+  void rebuild();
+};
+
+}
+
+#endif //ECS_FRAMEWORK_HIERARCHY_HPP
@@ -0,0 +1,176 @@
+//
+// JobPool.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "JobPool.hpp"
+
+#include <algorithm>
+
+namespace ecs {
+
+namespace {
+
+/// \brief Queue index of the current thread in the pool it works for
+thread_local const JobPool* currentPool = nullptr;
+thread_local unsigned currentQueue = 0;
+/// \brief Context of the job the current thread is running
+thread_local size_t currentContext = JobPool::no_context;
+
+/// \brief Workers the shared pool is created with
+unsigned& shared_threads()
+{
+  static unsigned threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+  return threads;
+}
+
+}
+
+JobPool::JobPool(unsigned threads)
+  : queued_(0), running_(true)
+{
+  for ( unsigned q = 0; q <= threads; ++q )
+    queues_.emplace_back(new Queue);
+
+  for ( unsigned t = 0; t < threads; ++t )
+    threads_.emplace_back(&JobPool::work, this, t);
+}
+
+JobPool::~JobPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    running_ = false;
+  }
+
+  wake_.notify_all();
+
+  for ( auto& thread : threads_ )
+    thread.join();
+}
+
+void JobPool::submit(Job job, JobCounter* counter)
+{
+  Task task { std::move(job), counter, currentContext };
+
+  if ( counter != nullptr )
+    counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+  if ( threads_.empty() ) {
+    execute(task);
+    return;
+  }
+
+  // Workers push to their own queue, everyone else shares the last one
+  auto index = (currentPool == this) ? currentQueue : thread_count();
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    queued_.fetch_add(1, std::memory_order_release);
+  }
+
+  wake_.notify_one();
+}
+
+void JobPool::wait(const JobCounter& counter)
+{
+  auto index = (currentPool == this) ? currentQueue : thread_count();
+
+  while ( !counter.done() ) {
+    if ( !run_one(index) )
+      std::this_thread::yield();
+  }
+}
+
+size_t JobPool::context()
+{
+  return currentContext;
+}
+
+void JobPool::set_context(size_t context)
+{
+  currentContext = context;
+}
+
+JobPool& JobPool::shared()
+{
+  static JobPool pool(shared_threads());
+  return pool;
+}
+
+void JobPool::set_shared_threads(unsigned threads)
+{
+  shared_threads() = threads;
+}
+
+void JobPool::work(unsigned index)
+{
+  currentPool = this;
+  currentQueue = index;
+
+  while ( running_ ) {
+    if ( run_one(index) )
+      continue;
+
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    wake_.wait(lock, [this] { return queued_ > 0 || !running_; });
+  }
+}
+
+bool JobPool::run_one(unsigned index)
+{
+  Task task;
+  auto found = false;
+
+  // Own queue first, newest job first for locality
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    auto& tasks = queues_[index]->tasks;
+    if ( !tasks.empty() ) {
+      task = std::move(tasks.back());
+      tasks.pop_back();
+      found = true;
+    }
+  }
+
+  // Steal the oldest job from another queue
+  for ( size_t i = 1; !found && i < queues_.size(); ++i ) {
+    auto& victim = *queues_[(index + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if ( !victim.tasks.empty() ) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      found = true;
+    }
+  }
+
+  if ( !found )
+    return false;
+
+  queued_.fetch_sub(1, std::memory_order_relaxed);
+  execute(task);
+  return true;
+}
+
+void JobPool::execute(Task& task)
+{
+  // Jobs can run inside another jobs wait(), so the context is restored
+  auto outer = currentContext;
+  currentContext = task.context;
+  task.job();
+  currentContext = outer;
+
+  if ( task.counter != nullptr )
+    task.counter->pending.fetch_sub(1, std::memory_order_release);
+}
+
+}
@@ -0,0 +1,261 @@
+//
+// JobPool.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_JOBPOOL_HPP
+#define ECS_FRAMEWORK_JOBPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ecs {
+
+/// \brief JobCounter tracks the number of unfinished jobs submitted against it
+/// so a caller can wait for a group of jobs to complete
+struct JobCounter {
+  /// \brief Number of submitted jobs that haven't finished yet
+  std::atomic<uint32_t> pending { 0 };
+
+  /// \brief Checks if every job submitted against this counter has finished
+  /// \return True if no jobs are pending, false otherwise
+  inline bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+/// \brief JobPool is a work-stealing thread pool. Each worker owns a queue
+/// that it pushes to and pops from the back of, and steals from the front of
+/// other workers queues when its own is empty
+class JobPool {
+public:
+  /// \brief A unit of work
+  using Job = std::function<void()>;
+
+  /// \brief Context of threads that aren't running anything attributed
+  static constexpr size_t no_context = SIZE_MAX;
+
+  /// \brief Starts a pool with the given number of worker threads
+  /// \param threads Number of workers. With zero workers every job runs
+  /// inline on the submitting thread in submission order
+  explicit JobPool(unsigned threads);
+
+  /// \brief Stops and joins all worker threads
+  ~JobPool();
+
+  JobPool(const JobPool&) = delete;
+  JobPool& operator=(const JobPool&) = delete;
+
+  /// \brief Queues a job for execution
+  /// \param job Job to run
+  /// \param counter Counter incremented now and decremented once the job
+  /// has run, or nullptr
+  void submit(Job job, JobCounter* counter = nullptr);
+
+  /// \brief Blocks until every job submitted against a counter has finished,
+  /// running queued jobs on the calling thread in the meantime
+  /// \param counter Counter to wait on
+  void wait(const JobCounter& counter);
+
+  /// \brief Gets the number of worker threads
+  /// \return Number of workers, not including threads calling wait()
+  inline unsigned thread_count() const
+  {
+    return static_cast<unsigned>(threads_.size());
+  }
+
+  /// \brief Gets the pool shared by the scheduler and parallel iteration,
+  /// created on first use with one worker per hardware thread besides the
+  /// calling thread unless set_shared_threads() says otherwise
+  /// \return The shared pool
+  static JobPool& shared();
+
+  /// \brief Sets the number of workers the shared pool is created with,
+  /// e.g. zero to run everything on the calling thread. Only has an effect
+  /// before the shared pool is first used
+  /// \param threads Number of workers
+  static void set_shared_threads(unsigned threads);
+
+  /// \brief Gets the calling threads job context, a value each job inherits
+  /// from the thread that submitted it. The scheduler sets it to the running
+  /// task so work split off a task is still attributed to that task
+  /// \return The context, or no_context
+  static size_t context();
+
+  /// \brief Sets the calling threads job context
+  /// \param context The new context
+  static void set_context(size_t context);
+
+private:
+  /// \brief A queued job, the counter to signal when it finishes and the
+  /// context it was submitted from
+  struct Task {
+    Job job;
+    JobCounter* counter;
+    size_t context;
+  };
+
+  /// \brief A workers job queue
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  /// \brief One queue per worker plus a final queue shared by external threads
+  std::vector<std::unique_ptr<Queue>> queues_;
+  /// \brief Worker threads
+  std::vector<std::thread> threads_;
+  /// \brief Number of tasks currently queued across all queues
+  std::atomic<uint32_t> queued_;
+  /// \brief Cleared to shut the workers down
+  std::atomic<bool> running_;
+  /// \brief Used to put idle workers to sleep
+  std::mutex sleepMutex_;
+  std::condition_variable wake_;
+
+  /// \brief Worker thread entry point
+  /// \param index Index of the workers queue
+  void work(unsigned index);
+
+  /// \brief Pops a task from a queue, stealing from the others if it's empty,
+  /// and runs it
+  /// \param index Queue to pop from first
+  /// \return True if a task was run, false if every queue was empty
+  bool run_one(unsigned index);
+
+  /// \brief Runs a task and signals its counter
+  static void execute(Task& task);
+};
+
+/// \brief Size in bytes assumed for a cache line when splitting work
+constexpr size_t cache_line_size = 64;
+
+/// \brief Gets the greatest common divisor of two sizes
+constexpr size_t gcd(size_t a, size_t b)
+{
+  return b == 0 ? a : gcd(b, a % b);
+}
+
+/// \brief Gets the number of elements between consecutive cache line aligned
+/// elements of an array
+/// \tparam T Type of the array elements
+template <typename T>
+constexpr size_t line_step()
+{
+  return cache_line_size / gcd(sizeof(T), cache_line_size);
+}
+
+/// \brief Checks if an array element starts a cache line
+/// \param data Start of the array
+/// \param index Index of the element
+template <typename T>
+inline bool starts_line(const T* data, size_t index)
+{
+  return (reinterpret_cast<uintptr_t>(data) + index * sizeof(T)) % cache_line_size == 0;
+}
+
+/// \brief Runs fn(begin, end) over ranges of [0, count) whose boundaries, other
+/// than the first, are first plus a multiple of step, blocking until all
+/// ranges have finished
+/// \param count Number of elements to process
+/// \param first First boundary, less than step
+/// \param step Number of elements boundaries are a multiple of apart
+/// \param grain Target number of elements per range
+/// \param fn Function called as fn(size_t begin, size_t end)
+/// \param pool Pool to run ranges on
+template <typename Fn>
+void parallel_for_steps(size_t count, size_t first, size_t step, size_t grain,
+                        Fn&& fn, JobPool& pool)
+{
+  grain = ((std::max<size_t>(grain, 1) + step - 1) / step) * step;
+
+  if ( count <= grain || pool.thread_count() == 0 ) {
+    fn(size_t(0), count);
+    return;
+  }
+
+  JobCounter counter;
+  size_t begin = 0;
+  auto end = (first == 0) ? grain : first;
+
+  while ( begin < count ) {
+    end = std::min(end, count);
+    pool.submit([&fn, begin, end] { fn(begin, end); }, &counter);
+    begin = end;
+    end += grain;
+  }
+
+  pool.wait(counter);
+}
+
+/// \brief Runs fn(begin, end) over consecutive ranges of [0, count) on a pool,
+/// blocking until all ranges have finished. Range boundaries are placed on
+/// cache line starts of the array being processed so two jobs never write to
+/// the same line
+/// \tparam T Type of the array elements
+/// \param data Start of the array being processed, used to find line starts
+/// \param count Number of elements to process
+/// \param grain Target number of elements per range, rounded up to a whole
+/// number of cache lines
+/// \param fn Function called as fn(size_t begin, size_t end)
+/// \param pool Pool to run ranges on
+template <typename T, typename Fn>
+void parallel_for(const T* data, size_t count, size_t grain, Fn&& fn,
+                  JobPool& pool = JobPool::shared())
+{
+  // Find the first element starting a cache line, if the array has any
+  auto step = line_step<T>();
+  size_t first = 0;
+  while ( first < step && !starts_line(data, first) )
+    first++;
+
+  parallel_for_steps(count, (first == step) ? 0 : first, step, grain, fn, pool);
+}
+
+/// \brief Runs fn(begin, end) over consecutive ranges of [0, count) on a pool
+/// for work that writes two parallel arrays. Range boundaries are placed on
+/// elements starting a cache line in both arrays, so jobs don't share a line
+/// of either. If the arrays' lines never start at the same element, only the
+/// first array is aligned to
+/// \tparam T Type of the first arrays elements
+/// \tparam U Type of the second arrays elements
+/// \param data Start of the first array
+/// \param other Start of the second array
+/// \param count Number of elements to process
+/// \param grain Target number of elements per range, rounded up to a whole
+/// number of boundaries
+/// \param fn Function called as fn(size_t begin, size_t end)
+/// \param pool Pool to run ranges on
+template <typename T, typename U, typename Fn>
+void parallel_for(const T* data, const U* other, size_t count, size_t grain,
+                  Fn&& fn, JobPool& pool = JobPool::shared())
+{
+  // Both steps are powers of two, so the larger is a multiple of the other
+  auto step = std::max(line_step<T>(), line_step<U>());
+  size_t first = 0;
+  while ( first < step && !(starts_line(data, first) && starts_line(other, first)) )
+    first++;
+
+  if ( first == step ) {
+    parallel_for(data, count, grain, fn, pool);
+    return;
+  }
+
+  parallel_for_steps(count, first, step, grain, fn, pool);
+}
+
+}
+
+#endif //ECS_FRAMEWORK_JOBPOOL_HPP
@@ -10,12 +10,19 @@
 
 #include <iostream>
 #include <fstream>
+#include <functional>
+#include <string>
 #include <vector>
 
 #include <SFML/Graphics.hpp>
-#include <FPSCounter.hpp>
+#include <PerfCounters.hpp>
+#include <Profiler.hpp>
 #include <GameObject.hpp>
 #include <Entity.hpp>
+#include <Collision.hpp>
+#include <DoubleBuffer.hpp>
+#include <Sprite.hpp>
+#include <Transform.hpp>
 
 /// \brief Fills a vector of sprites with the needed data
 /// \param sprites Vector to fill
@@ -31,6 +38,29 @@ void setup_raw(std::vector<sf::Sprite> &sprites, const int numEntities, sf::Text
   }
 }
 
+/// \brief Ids of the profiler zones timed every frame, registered once up
+/// front so timing them doesn't take the profilers lock
+struct FrameZones {
+  /// Each experiments whole frame, indexed by test type
+  uint32_t frames[3];
+  uint32_t benchmark;
+  uint32_t oopUpdate;
+  uint32_t oopAabb;
+  uint32_t oopDraw;
+  uint32_t ecsRender;
+
+  /// \brief Registers every zone
+  /// \param profiler Profiler to register with
+  explicit FrameZones(ecs::Profiler& profiler)
+    : frames { profiler.zone("Raw Frame"), profiler.zone("OOP Frame"),
+               profiler.zone("ECS Frame") },
+      benchmark(profiler.zone("Benchmark")),
+      oopUpdate(profiler.zone("OOP Update")),
+      oopAabb(profiler.zone("OOP AABB")),
+      oopDraw(profiler.zone("OOP Draw")),
+      ecsRender(profiler.zone("ECS Render")) {}
+};
+
 /// \brief Sets up all game objects with the necessary data
 /// \param gameObjects Container to setup
 /// \param numEntities Number of entities to create
@@ -50,16 +80,34 @@ void setup_oo(std::vector<ecs::Character> &gameObjects, const int numEntities, s
 /// correct order
 /// \param gameObjects Container to update
 /// \param window Window to draw the game objects sprites to
-void update_game_objects(std::vector<ecs::Character> &gameObjects, sf::RenderWindow &window)
+/// \param counters Hardware counters to measure each pass with
+/// \param report Report to add each passes counts to
+/// \param profiler Profiler to time each pass with
+/// \param zones Zones to time each pass as
+void update_game_objects(std::vector<ecs::Character> &gameObjects, sf::RenderWindow &window,
+                         const ecs::PerfCounters &counters, ecs::CounterReport &report,
+                         ecs::Profiler &profiler, const FrameZones &zones)
 {
-  for ( int i = 0; i < gameObjects.size(); ++i ) {
-    gameObjects[i].update();
+  {
+    ecs::ProfileZone zone(profiler, zones.oopUpdate);
+    ecs::ScopedCounters scope(counters, report, "OOP Update");
+    for ( int i = 0; i < gameObjects.size(); ++i ) {
+      gameObjects[i].update();
+    }
   }
-  for ( int i = 0; i < gameObjects.size(); ++i ) {
-    gameObjects[i].update_aabb();
+  {
+    ecs::ProfileZone zone(profiler, zones.oopAabb);
+    ecs::ScopedCounters scope(counters, report, "OOP AABB");
+    for ( int i = 0; i < gameObjects.size(); ++i ) {
+      gameObjects[i].update_aabb();
+    }
   }
-  for ( int i = 0; i < gameObjects.size(); ++i ) {
-    gameObjects[i].draw(window);
+  {
+    ecs::ProfileZone zone(profiler, zones.oopDraw);
+    ecs::ScopedCounters scope(counters, report, "OOP Draw");
+    for ( int i = 0; i < gameObjects.size(); ++i ) {
+      gameObjects[i].draw(window);
+    }
   }
 }
 
@@ -84,29 +132,54 @@ void update_sprites(std::vector<sf::Sprite> &sprites, sf::RenderWindow &window)
 void setup_dod(ecs::EntityMap &ecs, const int numEntities, sf::Texture &texture)
 {
   auto render = ecs.add_system<ecs::SpriteSystem>();
-  auto movement = ecs.add_system<ecs::CollisionSystem>();
+  auto movement = ecs.add_system<ecs::MovementSystem>("Movement");
+  auto collision = ecs.add_system<ecs::CollisionSystem>("Collision");
   auto textureSize = texture.getSize();
 
-  for ( int i = 0; i < numEntities; ++i ) {
-    auto e = ecs.create();
-    ecs.attach<ecs::SpriteSystem>(e);
-    ecs.attach<ecs::CollisionSystem>(e);
+  auto entities = ecs.create_many(numEntities);
+  ecs.attach<ecs::SpriteSystem>(entities);
+  ecs.attach<ecs::MovementSystem>(entities);
+  ecs.attach<ecs::CollisionSystem>(entities);
 
-    render->spriteData.get(e)->setTexture(texture);
-    render->spriteData.get(e)->setPosition(i * textureSize.x, i);
-
-    *(movement->boxes.get(e)) = render->spriteData.get(e)->getLocalBounds();
+  for ( int i = 0; i < numEntities; ++i ) {
+    auto e = entities[i];
+    ecs::Transform transform;
+    transform.position = sf::Vector2f(i * textureSize.x, i);
+    transform.velocity = sf::Vector2f(1, 1);
+    movement->transforms.set(e, transform);
+
+    auto sprite = render->spriteData.get(e);
+    sprite->setTexture(texture);
+    sprite->setPosition(transform.position);
   }
+
+  // Boxes start at each sprites world bounds and move with its transform
+  ecs.each<ecs::SpriteSystem, ecs::CollisionSystem>(
+    [](const ecs::Entity&, sf::Sprite& sprite, sf::FloatRect& box) {
+      box = sprite.getGlobalBounds();
+    }
+  );
+  collision->follow = &movement->transforms;
 }
 
 /// \brief Entry point
 int main(int argc, char** argv) {
 
+  // Counters only follow threads started after them, so open them before the
+  // EntityMap starts the job pool
+  ecs::PerfCounters counters;
+  ecs::CounterReport report;
+
+  // Rows are written in the order plots.py expects
+  for ( auto system : { "Benchmark", "ECS Movement", "ECS Collision", "ECS Render",
+                        "OOP Update", "OOP AABB", "OOP Draw" } ) {
+    report.add(system, ecs::CounterValues());
+  }
+
   auto numEntities = UINT16_MAX;
   
   auto testType = 0;
   auto iteration = 0;
-  std::vector<std::tuple<int, float>> averages;
 
   // Get the desktops current resolution and divide it by 1.3
   // to make it smaller
@@ -127,11 +200,58 @@ int main(int argc, char** argv) {
   sf::FloatRect check(10, 10, 10, 10);
 
   setup_dod(ecs, numEntities, texture);
+  ecs.get_system<ecs::CollisionSystem>()->query = check;
+
+  // --serial runs systems one after another on this thread for debugging,
+  // --pipeline draws each frame while the next one is simulated
+  auto pipelined = false;
+  for ( int arg = 1; arg < argc; ++arg ) {
+    if ( std::string(argv[arg]) == "--serial" )
+      ecs.scheduler().set_serial(true);
+    if ( std::string(argv[arg]) == "--pipeline" )
+      pipelined = true;
+  }
+
+  auto sprites = ecs.get_system<ecs::SpriteSystem>();
+  auto movement = ecs.get_system<ecs::MovementSystem>();
+  ecs::DoubleBuffer<ecs::SpriteFrame> spriteFrames;
+  sprites->prepare(spriteFrames.write());
+  spriteFrames.swap();
+
+  // Counters can't tell concurrent systems apart so measure them serially
+  if ( counters.available() )
+    ecs.scheduler().set_serial(true);
+
+  ecs::Profiler profiler;
+  profiler.set_tracing(true);
+
+  FrameZones zones(profiler);
+
+  // Each systems zone and counter name is made once rather than per frame
+  std::vector<std::string> taskNames;
+  std::vector<uint32_t> taskZones;
+  for ( size_t t = 0; t < ecs.scheduler().size(); ++t ) {
+    taskNames.push_back("ECS " + ecs.scheduler().name(t));
+    taskZones.push_back(profiler.zone(taskNames.back()));
+  }
+
+  ecs.scheduler().set_wrapper(
+    [&](size_t index, const std::string&, const std::function<void()>& task) {
+      ecs::ProfileZone zone(profiler, taskZones[index]);
+      ecs::ScopedCounters scope(counters, report, taskNames[index]);
+      task();
+    }
+  );
+
   setup_oo(testObjects, numEntities, texture, check);
   setup_raw(rawSprites, numEntities, texture);
 
-  ecs::FPSCounter fps;
-  ecs::FPSCounter sampleFps;
+  // Each experiments frames are also timed as a zone to get its percentiles
+  uint64_t sampleStart = 0;
+  uint64_t sampleFrames = 0;
+
+  // Don't count setup as part of the first frame
+  profiler.reset();
 
   std::ofstream csv(
     "/Users/jacobmilligan/Uni/OOP/ResearchReport/code/data.csv"
@@ -140,49 +260,84 @@ int main(int argc, char** argv) {
 
   while ( window.isOpen() && testType < 3 ) {
 
-    while ( sampleFps.total_frames() <= 60.0f ) {
-      sf::Event event;
-
-      while ( window.pollEvent(event) ) {
-
-        if ( event.type == sf::Event::Closed )
-          window.close();
-
-      }
-
-      window.clear(sf::Color::Black);
-
-      switch (testType) {
-        case 0:
-          update_sprites(rawSprites, window);
-          break;
-        case 1:
-          update_game_objects(testObjects, window);
-          break;
-        case 2:
-          ecs.get_system<ecs::SpriteSystem>()->move();
-          ecs.get_system<ecs::CollisionSystem>()->update_collision(check);
-          ecs.get_system<ecs::SpriteSystem>()->render(window);
-          break;
+    while ( sampleFrames <= 60 ) {
+      {
+        ecs::ProfileZone frame(profiler, zones.frames[testType]);
+        sf::Event event;
+
+        while ( window.pollEvent(event) ) {
+
+          if ( event.type == sf::Event::Closed )
+            window.close();
+
+        }
+
+        window.clear(sf::Color::Black);
+
+        switch (testType) {
+          case 0: {
+            ecs::ProfileZone zone(profiler, zones.benchmark);
+            ecs::ScopedCounters scope(counters, report, "Benchmark");
+            update_sprites(rawSprites, window);
+            break;
+          }
+          case 1:
+            update_game_objects(testObjects, window, counters, report, profiler, zones);
+            break;
+          case 2: {
+            if ( !pipelined ) {
+              ecs.update();
+
+              ecs::ProfileZone zone(profiler, zones.ecsRender);
+              ecs::ScopedCounters scope(counters, report, "ECS Render");
+              movement->sync(sprites->spriteData);
+              sprites->sort_by_texture(1024);
+              sprites->render(window);
+              break;
+            }
+
+            // Simulate and snapshot the next frame on the job pool while this
+            // thread draws the last snapshot, which shares nothing with it
+            ecs::JobCounter simulated;
+            ecs::JobPool::shared().submit([&] {
+              ecs.simulate();
+              movement->sync(sprites->spriteData);
+              sprites->sort_by_texture(1024);
+              sprites->prepare(spriteFrames.write());
+            }, &simulated);
+
+            {
+              ecs::ProfileZone zone(profiler, zones.ecsRender);
+              ecs::ScopedCounters scope(counters, report, "ECS Render");
+              ecs::SpriteSystem::draw(window, spriteFrames.read());
+            }
+
+            ecs::JobPool::shared().wait(simulated);
+            ecs.sync();
+            spriteFrames.swap();
+            break;
+          }
+        }
+
+        window.display();
       }
 
-      fps.update();
-      sampleFps.update();
-
-      window.display();
+      profiler.end_frame();
+      sampleFrames++;
     }
 
+    // Frame times are summed in integer nanoseconds so long runs stay exact
+    auto sampleTime = profiler.frames().total() - sampleStart;
     csv << testType << "," << iteration
-        << "," << sampleFps.average_delta_time() << "\n";
+        << "," << sampleTime / (sampleFrames * 1e9) << "\n";
 
     iteration++;
-    sampleFps.reset();
+    sampleStart = profiler.frames().total();
+    sampleFrames = 0;
 
     if ( iteration > 19 ) {
-      averages.emplace_back(testType, fps.average_delta_time());
       iteration = 0;
       testType++;
-      fps.reset();
     }
   }
 
@@ -190,5 +345,11 @@ int main(int argc, char** argv) {
 
   csv.close();
 
+  if ( counters.available() )
+    report.write_csv("/Users/jacobmilligan/Uni/OOP/ResearchReport/code/cache.csv");
+
+  profiler.write_summary("/Users/jacobmilligan/Uni/OOP/ResearchReport/code/profile.csv");
+  profiler.write_chrome_trace("/Users/jacobmilligan/Uni/OOP/ResearchReport/code/trace.json");
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+//
+// PerfCounters.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "PerfCounters.hpp"
+
+#include <fstream>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ecs {
+
+namespace {
+
+/// \brief Number of fields in CounterValues
+constexpr size_t counter_count = 7;
+
+/// \brief Gets a CounterValues field by index
+uint64_t& field(CounterValues& values, size_t index)
+{
+  uint64_t* fields[] = {
+    &values.cycles, &values.instructions, &values.cache_references,
+    &values.cache_misses, &values.branch_misses, &values.l1d_misses,
+    &values.l1i_misses
+  };
+  return *fields[index];
+}
+
+#ifdef __linux__
+
+/// \brief Gets the config of a read-miss hardware cache event
+uint64_t cache_miss(uint64_t cache)
+{
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+/// \brief Opens a counter for the calling thread and its future children
+/// \param leader Group leader to join, or -1 to open a new group leader
+int open_counter(uint32_t type, uint64_t config, int leader)
+{
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP
+    | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+}
+
+#endif
+
+}
+
+CounterValues& CounterValues::operator+=(const CounterValues& other)
+{
+  auto copy = other;
+  for ( size_t i = 0; i < counter_count; ++i )
+    field(*this, i) += field(copy, i);
+  return *this;
+}
+
+PerfCounters::PerfCounters()
+  : available_(false)
+{
+#ifdef __linux__
+  const std::pair<uint32_t, uint64_t> events[counter_count] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1D) },
+    { PERF_TYPE_HW_CACHE, cache_miss(PERF_COUNT_HW_CACHE_L1I) }
+  };
+
+  // Every counter joins the cycles counters group so they're scheduled onto
+  // the PMU together, keeping ratios between them consistent when the kernel
+  // multiplexes
+  available_ = true;
+  for ( auto& event : events ) {
+    auto leader = fds_.empty() ? -1 : fds_.front();
+    fds_.push_back(open_counter(event.first, event.second, leader));
+    available_ &= fds_.back() >= 0;
+    if ( !available_ )
+      break;
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+  for ( auto fd : fds_ ) {
+    if ( fd >= 0 )
+      close(fd);
+  }
+#endif
+}
+
+CounterValues PerfCounters::read() const
+{
+  CounterValues values;
+
+#ifdef __linux__
+  if ( !available_ )
+    return values;
+
+  // Reading the leader returns the whole group: counter count, time enabled,
+  // time running, then each counters value in the order they joined
+  uint64_t data[3 + counter_count] = {};
+  if ( ::read(fds_.front(), data, sizeof(data)) != sizeof(data) || data[0] != counter_count )
+    return values;
+
+  // The group is only ever scheduled as a whole, so one scale applies to
+  // every counter
+  auto enabled = data[1];
+  auto running = data[2];
+  for ( size_t i = 0; i < counter_count; ++i ) {
+    auto value = data[3 + i];
+    if ( running > 0 && running < enabled )
+      value = static_cast<uint64_t>(static_cast<double>(value) * enabled / running);
+
+    field(values, i) = value;
+  }
+#endif
+
+  return values;
+}
+
+void CounterReport::add(const std::string& system, const CounterValues& values)
+{
+  for ( auto& row : rows_ ) {
+    if ( row.first == system ) {
+      row.second += values;
+      return;
+    }
+  }
+
+  rows_.emplace_back(system, values);
+}
+
+bool CounterReport::write_csv(const std::string& path) const
+{
+  std::ofstream csv(path);
+  if ( !csv )
+    return false;
+
+  csv << "System,iCache,L1,L2Proxy,L3,Cycles,Instructions,IPC,"
+      << "CacheReferences,CacheMisses,BranchMisses\n";
+
+  for ( auto& row : rows_ ) {
+    auto& v = row.second;
+    auto instructions = static_cast<double>(v.instructions > 0 ? v.instructions : 1);
+    auto cycles = static_cast<double>(v.cycles > 0 ? v.cycles : 1);
+
+    csv << row.first << ","
+        << v.l1i_misses / instructions << ","
+        << v.l1d_misses / instructions << ","
+        << v.cache_references / instructions << ","
+        << v.cache_misses / instructions << ","
+        << v.cycles << "," << v.instructions << ","
+        << v.instructions / cycles << ","
+        << v.cache_references << "," << v.cache_misses << ","
+        << v.branch_misses << "\n";
+  }
+
+  return true;
+}
+
+ScopedCounters::~ScopedCounters()
+{
+  auto end = counters_.read();
+  CounterValues delta;
+  for ( size_t i = 0; i < counter_count; ++i )
+    field(delta, i) = field(end, i) - field(start_, i);
+
+  report_.add(system_, delta);
+}
+
+}
@@ -0,0 +1,120 @@
+//
+// PerfCounters.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_PERFCOUNTERS_HPP
+#define ECS_FRAMEWORK_PERFCOUNTERS_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ecs {
+
+/// \brief CounterValues holds hardware event counts for a measured region
+struct CounterValues {
+  uint64_t cycles = 0;
+  uint64_t instructions = 0;
+  /// Last level cache references. There's no portable L2 miss event, so
+  /// these stand in for L2 misses, which they approximate on most CPUs
+  uint64_t cache_references = 0;
+  /// Last level cache misses
+  uint64_t cache_misses = 0;
+  uint64_t branch_misses = 0;
+  uint64_t l1d_misses = 0;
+  uint64_t l1i_misses = 0;
+
+  /// \brief Adds another set of counts to this one
+  CounterValues& operator+=(const CounterValues& other);
+};
+
+/// \brief PerfCounters reads hardware performance counters through Linux
+/// perf_event_open. Every counter is opened in one group so the kernel
+/// schedules them together, and counts are scaled by the groups time enabled
+/// over time running if it had to be multiplexed. Counters follow the thread
+/// that creates them and any threads it starts afterwards, so create them
+/// before the JobPool to include work done by its workers. On other
+/// platforms, or when the kernel refuses access, available() is false and
+/// every read returns zeros
+class PerfCounters {
+public:
+  /// \brief Opens and starts every counter
+  PerfCounters();
+
+  /// \brief Closes every counter
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  /// \brief Checks if the counters could be opened
+  /// \return True if counts are being collected, false otherwise
+  inline bool available() const { return available_; }
+
+  /// \brief Reads the running totals of every counter, scaled up if the
+  /// kernel had to multiplex them
+  /// \return Counts since the counters were opened
+  CounterValues read() const;
+
+private:
+  /// \brief File descriptor of each counter, in CounterValues field order
+  std::vector<int> fds_;
+  /// \brief Whether every counter opened
+  bool available_;
+};
+
+/// \brief CounterReport accumulates counts per named system and writes them in
+/// the cache.csv format plots.py reads
+class CounterReport {
+public:
+  /// \brief Adds counts to a system, creating its row on first use. Rows are
+  /// written in the order they were first added
+  /// \param system Name of the system
+  /// \param values Counts to add
+  void add(const std::string& system, const CounterValues& values);
+
+  /// \brief Writes a row per system with iCache, L1, L2 and L3 misses per
+  /// instruction followed by the raw totals and instructions per cycle. The
+  /// L2 column is derived from last level cache references rather than
+  /// measured, so it's headed L2Proxy
+  /// \param path File to write
+  /// \return True if the file was written, false otherwise
+  bool write_csv(const std::string& path) const;
+
+private:
+  /// \brief Totals for each system in first-use order
+  std::vector<std::pair<std::string, CounterValues>> rows_;
+};
+
+/// \brief ScopedCounters adds the counts of its own lifetime to a report
+class ScopedCounters {
+public:
+  /// \brief Starts measuring
+  /// \param counters Counters to read
+  /// \param report Report to add the counts to
+  /// \param system Name of the system being measured
+  ScopedCounters(const PerfCounters& counters, CounterReport& report,
+                 const std::string& system)
+    : counters_(counters), report_(report), system_(system),
+      start_(counters.read()) {}
+
+  /// \brief Stops measuring and adds the difference to the report
+  ~ScopedCounters();
+
+private:
+  const PerfCounters& counters_;
+  CounterReport& report_;
+  std::string system_;
+  CounterValues start_;
+};
+
+}
+
+#endif //ECS_FRAMEWORK_PERFCOUNTERS_HPP
@@ -0,0 +1,265 @@
+//
+// Profiler.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace ecs {
+
+namespace {
+
+/// \brief Source of unique profiler serials, so a profiler allocated at a
+/// destroyed ones address never sees its cached buffer
+std::atomic<uint64_t> nextSerial(1);
+
+/// \brief Serial of the profiler and buffer most recently used by the calling
+/// thread, so recording only takes a lock the first time a thread records
+thread_local uint64_t cachedSerial = 0;
+thread_local void* cachedBuffer = nullptr;
+
+/// \brief Gets the index of the highest set bit
+inline uint32_t highest_bit(uint64_t value)
+{
+  return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+}
+
+}
+
+void Histogram::record(uint64_t ns)
+{
+  counts_[bucket_of(ns)]++;
+  count_++;
+  sum_ += ns;
+  if ( ns > max_ )
+    max_ = ns;
+}
+
+uint64_t Histogram::percentile(double p) const
+{
+  if ( count_ == 0 )
+    return 0;
+
+  auto target = static_cast<uint64_t>(p * count_);
+  if ( target >= count_ )
+    target = count_ - 1;
+
+  uint64_t seen = 0;
+  for ( uint32_t b = 0; b < bucket_count; ++b ) {
+    seen += counts_[b];
+    if ( seen > target ) {
+      // Report the middle of the bucket, capped by the true maximum
+      auto low = lower_bound(b);
+      auto high = (b + 1 < bucket_count) ? lower_bound(b + 1) : max_;
+      auto mid = low + (high - low) / 2;
+      return mid < max_ ? mid : max_;
+    }
+  }
+
+  return max_;
+}
+
+void Histogram::reset()
+{
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  sum_ = 0;
+  max_ = 0;
+}
+
+uint32_t Histogram::bucket_of(uint64_t ns)
+{
+  const uint64_t subCount = uint64_t(1) << sub_bits;
+  if ( ns < subCount )
+    return static_cast<uint32_t>(ns);
+
+  auto exponent = highest_bit(ns);
+  auto sub = (ns >> (exponent - sub_bits)) & (subCount - 1);
+  return ((exponent - sub_bits + 1) << sub_bits) + static_cast<uint32_t>(sub);
+}
+
+uint64_t Histogram::lower_bound(uint32_t bucket)
+{
+  const uint64_t subCount = uint64_t(1) << sub_bits;
+  if ( bucket < subCount )
+    return bucket;
+
+  auto exponent = (bucket >> sub_bits) + sub_bits - 1;
+  auto sub = bucket & (subCount - 1);
+  return (subCount + sub) << (exponent - sub_bits);
+}
+
+Profiler::Profiler()
+  : frameStart_(now_ns()), traceCapacity_(default_trace_capacity),
+    traceNext_(0), traceOverwritten_(0), tracing_(false), dropped_(0),
+    serial_(nextSerial.fetch_add(1)) {}
+
+void Profiler::set_tracing(bool tracing, size_t capacity)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  tracing_ = tracing;
+  if ( capacity != traceCapacity_ ) {
+    traceCapacity_ = capacity;
+    trace_.clear();
+    trace_.shrink_to_fit();
+    traceNext_ = 0;
+  }
+}
+
+uint32_t Profiler::zone(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto found = ids_.find(name);
+  if ( found != ids_.end() )
+    return found->second;
+
+  auto id = static_cast<uint32_t>(names_.size());
+  names_.push_back(name);
+  zones_.emplace_back();
+  ids_.emplace(name, id);
+  return id;
+}
+
+void Profiler::record(uint32_t zone, uint64_t start, uint64_t end)
+{
+  auto& buf = buffer();
+  auto size = buf.size.load(std::memory_order_relaxed);
+  if ( size >= events_per_thread ) {
+    buf.dropped.store(buf.dropped.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_relaxed);
+    return;
+  }
+
+  buf.events[size] = Event { zone, buf.thread, start, end };
+  buf.size.store(size + 1, std::memory_order_release);
+}
+
+void Profiler::end_frame()
+{
+  auto now = now_ns();
+  frames_.record(now - frameStart_);
+  frameStart_ = now;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for ( auto& buf : buffers_ ) {
+    auto size = buf->size.load(std::memory_order_acquire);
+    for ( uint32_t e = 0; e < size; ++e ) {
+      auto& event = buf->events[e];
+      zones_[event.zone].record(event.end - event.start);
+      if ( !tracing_ || traceCapacity_ == 0 )
+        continue;
+
+      if ( trace_.size() < traceCapacity_ ) {
+        trace_.push_back(event);
+      } else {
+        trace_[traceNext_] = event;
+        traceOverwritten_++;
+      }
+      traceNext_ = (traceNext_ + 1) % traceCapacity_;
+    }
+
+    dropped_ += buf->dropped.load(std::memory_order_relaxed);
+    buf->dropped.store(0, std::memory_order_relaxed);
+    buf->size.store(0, std::memory_order_release);
+  }
+}
+
+const Histogram& Profiler::zone_times(const std::string& name)
+{
+  return zones_[zone(name)];
+}
+
+void Profiler::reset()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  frameStart_ = now_ns();
+  frames_.reset();
+  for ( auto& histogram : zones_ )
+    histogram.reset();
+}
+
+bool Profiler::write_chrome_trace(const std::string& path) const
+{
+  std::ofstream json(path);
+  if ( !json )
+    return false;
+
+  auto origin = trace_.empty() ? 0 : trace_.front().start;
+  for ( auto& event : trace_ ) {
+    if ( event.start < origin )
+      origin = event.start;
+  }
+
+  // Once the ring has wrapped the oldest event is the next to be replaced
+  auto first = (trace_.size() < traceCapacity_) ? 0 : traceNext_;
+
+  // Complete events with microsecond timestamps, one track per thread
+  json << "{\"traceEvents\":[";
+  for ( size_t e = 0; e < trace_.size(); ++e ) {
+    auto& event = trace_[(first + e) % trace_.size()];
+    json << (e > 0 ? ",\n" : "\n")
+         << "{\"name\":\"" << names_[event.zone] << "\",\"ph\":\"X\",\"pid\":0"
+         << ",\"tid\":" << event.thread
+         << ",\"ts\":" << (event.start - origin) / 1000.0
+         << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+  }
+  json << "\n]}\n";
+
+  return true;
+}
+
+bool Profiler::write_summary(const std::string& path) const
+{
+  std::ofstream csv(path);
+  if ( !csv )
+    return false;
+
+  auto row = [&](const std::string& name, const Histogram& h) {
+    csv << name << "," << h.count() << "," << h.mean() << ","
+        << h.percentile(0.50) << "," << h.percentile(0.95) << ","
+        << h.percentile(0.99) << "," << h.max() << "\n";
+  };
+
+  csv << "Zone,Count,Mean ns,P50 ns,P95 ns,P99 ns,Max ns\n";
+  row("Frame", frames_);
+  for ( size_t z = 0; z < names_.size(); ++z )
+    row(names_[z], zones_[z]);
+
+  return true;
+}
+
+Profiler::ThreadBuffer& Profiler::buffer()
+{
+  if ( cachedSerial == serial_ )
+    return *static_cast<ThreadBuffer*>(cachedBuffer);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto& buf = threads_[std::this_thread::get_id()];
+  if ( buf == nullptr ) {
+    buffers_.emplace_back(new ThreadBuffer);
+    buf = buffers_.back().get();
+    buf->events.reset(new Event[events_per_thread]);
+    buf->size = 0;
+    buf->dropped = 0;
+    buf->thread = static_cast<uint32_t>(buffers_.size() - 1);
+  }
+
+  cachedSerial = serial_;
+  cachedBuffer = buf;
+  return *buf;
+}
+
+}
@@ -0,0 +1,253 @@
+//
+// Profiler.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_PROFILER_HPP
+#define ECS_FRAMEWORK_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ecs {
+
+/// \brief Gets the current time from a monotonic clock
+/// \return Nanoseconds since an arbitrary epoch
+inline uint64_t now_ns()
+{
+  return static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()
+    ).count()
+  );
+}
+
+/// \brief Histogram records nanosecond durations into log-linear buckets, each
+/// power of two split into 32 sub-buckets, giving percentiles within about 3%
+/// of the true value at any scale with constant time recording. Totals are
+/// kept as integers so precision doesn't degrade over long runs
+class Histogram {
+public:
+  /// \brief Number of sub-buckets per power of two, as a power of two
+  static constexpr uint32_t sub_bits = 5;
+
+  /// \brief Initializes an empty histogram
+  Histogram() : counts_(bucket_count, 0), count_(0), sum_(0), max_(0) {}
+
+  /// \brief Records a duration
+  /// \param ns Duration in nanoseconds
+  void record(uint64_t ns);
+
+  /// \brief Gets a percentile of the recorded durations
+  /// \param p Percentile between 0 and 1
+  /// \return The duration in nanoseconds, or 0 if nothing was recorded
+  uint64_t percentile(double p) const;
+
+  /// \brief Gets the mean recorded duration
+  /// \return The mean in nanoseconds, or 0 if nothing was recorded
+  inline double mean() const
+  {
+    return count_ > 0 ? static_cast<double>(sum_) / count_ : 0.0;
+  }
+
+  /// \brief Gets the longest recorded duration
+  /// \return The maximum in nanoseconds
+  inline uint64_t max() const { return max_; }
+
+  /// \brief Gets the sum of every recorded duration
+  /// \return The total in nanoseconds
+  inline uint64_t total() const { return sum_; }
+
+  /// \brief Gets the number of recorded durations
+  /// \return The count
+  inline uint64_t count() const { return count_; }
+
+  /// \brief Removes all recorded durations
+  void reset();
+
+private:
+  /// \brief Total number of buckets needed for 64-bit durations
+  static constexpr uint32_t bucket_count = (64 - sub_bits + 1) << sub_bits;
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t max_;
+
+  /// \brief Gets the bucket a duration falls in
+  static uint32_t bucket_of(uint64_t ns);
+
+  /// \brief Gets the smallest duration that falls in a bucket
+  static uint64_t lower_bound(uint32_t bucket);
+};
+
+/// \brief Profiler times frames and named zones. Zones are recorded without
+/// locking into a fixed-size buffer owned by the recording thread and are
+/// folded into per-zone histograms by end_frame(), which also records the
+/// frame time. Optionally keeps the most recent events in a fixed-size ring
+/// for Chrome trace_event export
+class Profiler {
+public:
+  /// \brief Maximum events a thread can record per frame before dropping
+  static constexpr uint32_t events_per_thread = 1 << 16;
+
+  /// \brief Default number of events the trace ring keeps, about 24MB
+  static constexpr size_t default_trace_capacity = 1 << 20;
+
+  /// \brief Initializes a profiler and starts its first frame
+  Profiler();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  /// \brief Gets the id of a named zone, registering it on first use. Takes
+  /// a lock and a hash lookup, so hot paths should get ids once up front and
+  /// record with them
+  /// \param name Name of the zone
+  /// \return The zones id
+  uint32_t zone(const std::string& name);
+
+  /// \brief Records a zone on the calling thread. Lock-free once the thread
+  /// has recorded its first event
+  /// \param zone Id of the zone
+  /// \param start Start time in nanoseconds
+  /// \param end End time in nanoseconds
+  void record(uint32_t zone, uint64_t start, uint64_t end);
+
+  /// \brief Ends the current frame, recording its duration and folding every
+  /// threads zones into their histograms. Must be called while no other
+  /// thread is recording
+  void end_frame();
+
+  /// \brief Gets the frame time histogram
+  /// \return Histogram of frame durations
+  inline const Histogram& frames() const { return frames_; }
+
+  /// \brief Gets a zones histogram
+  /// \param name Name of the zone
+  /// \return Histogram of the zones durations
+  const Histogram& zone_times(const std::string& name);
+
+  /// \brief Clears every histogram and restarts the current frame, leaving
+  /// zones and trace events intact
+  void reset();
+
+  /// \brief Enables keeping events for write_chrome_trace(). Once the ring
+  /// is full each new event replaces the oldest, so memory stays bounded
+  /// however long tracing runs. Changing the capacity discards kept events
+  /// \param tracing True to keep events, false to stop
+  /// \param capacity Most events to keep
+  void set_tracing(bool tracing, size_t capacity = default_trace_capacity);
+
+  /// \brief Gets the number of traced events replaced by newer ones
+  /// \return Events lost from the start of the trace
+  inline uint64_t trace_overwritten() const { return traceOverwritten_; }
+
+  /// \brief Writes every kept event, oldest first, in Chrome trace_event
+  /// JSON format, for chrome://tracing or Perfetto
+  /// \param path File to write
+  /// \return True if the file was written, false otherwise
+  bool write_chrome_trace(const std::string& path) const;
+
+  /// \brief Writes p50, p95, p99 and max of the frame and every zone as CSV
+  /// \param path File to write
+  /// \return True if the file was written, false otherwise
+  bool write_summary(const std::string& path) const;
+
+  /// \brief Gets the number of events dropped because a thread buffer was full
+  /// \return Number of dropped events since the profiler was created
+  inline uint64_t dropped() const { return dropped_; }
+
+private:
+  /// \brief A recorded zone
+  struct Event {
+    uint32_t zone;
+    uint32_t thread;
+    uint64_t start;
+    uint64_t end;
+  };
+
+  /// \brief Events recorded by a single thread this frame. Only the owning
+  /// thread writes, and end_frame() reads at the sync point
+  struct ThreadBuffer {
+    std::unique_ptr<Event[]> events;
+    std::atomic<uint32_t> size;
+    /// Events that didn't fit this frame
+    std::atomic<uint32_t> dropped;
+    uint32_t thread;
+  };
+
+  /// \brief Guards zone registration and buffer creation
+  std::mutex mutex_;
+  /// \brief Zone names, indexed by id
+  std::vector<std::string> names_;
+  /// \brief Zone ids, keyed by name
+  std::unordered_map<std::string, uint32_t> ids_;
+  /// \brief Histogram of each zone, indexed by id
+  std::vector<Histogram> zones_;
+  /// \brief Buffer of every thread that has recorded
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+  /// \brief Buffer index of each thread that has recorded
+  std::unordered_map<std::thread::id, ThreadBuffer*> threads_;
+  /// \brief Frame durations
+  Histogram frames_;
+  /// \brief Start of the current frame
+  uint64_t frameStart_;
+  /// \brief Ring of the most recent events kept for tracing. Holds up to
+  /// capacity events, with traceNext_ the slot the next event goes in
+  std::vector<Event> trace_;
+  size_t traceCapacity_;
+  size_t traceNext_;
+  uint64_t traceOverwritten_;
+  bool tracing_;
+  uint64_t dropped_;
+  /// \brief Unique id used to cache each threads buffer
+  uint64_t serial_;
+
+  /// \brief Gets the calling threads buffer, creating it on first use
+  ThreadBuffer& buffer();
+};
+
+/// \brief ProfileZone records the duration of its lifetime as a zone
+class ProfileZone {
+public:
+  /// \brief Starts timing a zone
+  /// \param profiler Profiler to record to
+  /// \param zone Id of the zone from Profiler::zone()
+  ProfileZone(Profiler& profiler, uint32_t zone)
+    : profiler_(profiler), zone_(zone), start_(now_ns()) {}
+
+  /// \brief Starts timing a zone by name. Looks the zone up through
+  /// Profiler::zone(), so prefer the id constructor in hot paths
+  /// \param profiler Profiler to record to
+  /// \param name Name of the zone
+  ProfileZone(Profiler& profiler, const std::string& name)
+    : ProfileZone(profiler, profiler.zone(name)) {}
+
+  /// \brief Stops timing and records the zone
+  ~ProfileZone()
+  {
+    profiler_.record(zone_, start_, now_ns());
+  }
+
+private:
+  Profiler& profiler_;
+  uint32_t zone_;
+  uint64_t start_;
+};
+
+}
+
+#endif //ECS_FRAMEWORK_PROFILER_HPP
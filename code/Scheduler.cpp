@@ -0,0 +1,76 @@
+//
+// Scheduler.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "Scheduler.hpp"
+
+namespace ecs {
+
+void Scheduler::add(const std::string& name, const Access& access,
+                    std::function<void()> task)
+{
+  tasks_.push_back(Task { name, access, std::move(task), {}, 0 });
+  remaining_.reset(new std::atomic<uint32_t>[tasks_.size()]);
+}
+
+void Scheduler::run()
+{
+  if ( serial_ || pool_->thread_count() == 0 ) {
+    for ( size_t t = 0; t < tasks_.size(); ++t )
+      execute(t);
+    return;
+  }
+
+  build_graph();
+
+  JobCounter frame;
+  for ( size_t t = 0; t < tasks_.size(); ++t ) {
+    remaining_[t] = tasks_[t].dependencies;
+  }
+
+  for ( size_t t = 0; t < tasks_.size(); ++t ) {
+    if ( tasks_[t].dependencies == 0 )
+      submit(t, frame);
+  }
+
+  pool_->wait(frame);
+}
+
+void Scheduler::build_graph()
+{
+  for ( auto& task : tasks_ ) {
+    task.dependents.clear();
+    task.dependencies = 0;
+  }
+
+  for ( size_t t = 0; t < tasks_.size(); ++t ) {
+    for ( size_t earlier = 0; earlier < t; ++earlier ) {
+      if ( tasks_[t].access.conflicts_with(tasks_[earlier].access) ) {
+        tasks_[earlier].dependents.push_back(t);
+        tasks_[t].dependencies++;
+      }
+    }
+  }
+}
+
+void Scheduler::submit(size_t index, JobCounter& frame)
+{
+  pool_->submit([this, index, &frame] {
+    execute(index);
+
+    // Dependents are submitted before this job signals the frame counter so
+    // the frame can't be observed as finished early
+    for ( auto dependent : tasks_[index].dependents ) {
+      if ( remaining_[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1 )
+        submit(dependent, frame);
+    }
+  }, &frame);
+}
+
+}
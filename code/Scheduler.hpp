@@ -0,0 +1,154 @@
+//
+// Scheduler.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_SCHEDULER_HPP
+#define ECS_FRAMEWORK_SCHEDULER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JobPool.hpp"
+
+namespace ecs {
+
+/// \brief Access is the set of component types and resources a task reads
+/// and writes, stored as bitmasks of component ids and resource ids
+struct Access {
+  uint64_t reads = 0;
+  uint64_t writes = 0;
+  uint64_t resource_reads = 0;
+  uint64_t resource_writes = 0;
+
+  /// \brief Checks if two tasks can't safely run at the same time, which is
+  /// the case when either one writes a component or resource the other
+  /// accesses
+  /// \param other Access of the other task
+  /// \return True if the tasks conflict, false otherwise
+  inline bool conflicts_with(const Access& other) const
+  {
+    return (writes & (other.reads | other.writes)) != 0
+      || (other.writes & reads) != 0
+      || (resource_writes & (other.resource_reads | other.resource_writes)) != 0
+      || (other.resource_writes & resource_reads) != 0;
+  }
+
+  /// \brief Checks if the task declares any access
+  /// \return True if nothing is read or written, false otherwise
+  inline bool empty() const
+  {
+    return (reads | writes | resource_reads | resource_writes) == 0;
+  }
+};
+
+/// \brief Scheduler runs a set of tasks once per frame, running tasks whose
+/// component access doesn't conflict at the same time on a JobPool. Tasks
+/// that conflict run in the order they were added
+class Scheduler {
+public:
+  /// \brief Function run around every task, given the tasks index and name
+  /// and the task itself, which it must call. Used to instrument systems,
+  /// with the index letting per-task data be set up once rather than looked
+  /// up by name each frame
+  using TaskWrapper = std::function<
+    void(size_t, const std::string&, const std::function<void()>&)
+  >;
+
+  /// \brief Initializes an empty scheduler
+  /// \param pool Pool to run tasks on
+  explicit Scheduler(JobPool& pool = JobPool::shared())
+    : pool_(&pool), serial_(false) {}
+
+  /// \brief Adds a task to run every frame
+  /// \param name Name of the task for debugging
+  /// \param access Components the task reads and writes
+  /// \param task Function to run
+  void add(const std::string& name, const Access& access, std::function<void()> task);
+
+  /// \brief Runs every task once, blocking until all of them have finished.
+  /// The dependency graph is rebuilt from the tasks access on each call
+  void run();
+
+  /// \brief Enables the deterministic fallback, running every task on the
+  /// calling thread in the order they were added
+  /// \param serial True to run serially, false to run in parallel
+  inline void set_serial(bool serial) { serial_ = serial; }
+
+  /// \brief Sets a function to run around every task. It's called on the
+  /// thread running the task
+  /// \param wrapper Wrapper to use, or an empty function to remove it
+  inline void set_wrapper(TaskWrapper wrapper) { wrapper_ = std::move(wrapper); }
+
+  /// \brief Gets the number of tasks
+  /// \return Number of tasks
+  inline size_t size() const { return tasks_.size(); }
+
+  /// \brief Gets a tasks name
+  /// \param index Index of the task, in the order tasks were added
+  /// \return The name it was added with
+  inline const std::string& name(size_t index) const { return tasks_[index].name; }
+
+  /// \brief Gets the index of the task the calling thread is working for,
+  /// including jobs the task submitted to the pool
+  /// \return Index of the task, or JobPool::no_context outside of any task
+  static inline size_t current_task() { return JobPool::context(); }
+
+private:
+  /// \brief A scheduled task and its place in the current dependency graph
+  struct Task {
+    std::string name;
+    Access access;
+    std::function<void()> fn;
+    /// Tasks that can't start until this one has finished
+    std::vector<size_t> dependents;
+    /// Number of tasks this one waits on
+    uint32_t dependencies;
+  };
+
+  /// \brief All tasks in the order they were added
+  std::vector<Task> tasks_;
+  /// \brief Dependencies left before each task can run in the current frame
+  std::unique_ptr<std::atomic<uint32_t>[]> remaining_;
+  /// \brief Pool tasks are run on
+  JobPool* pool_;
+  /// \brief Whether to use the single threaded fallback
+  bool serial_;
+  /// \brief Function run around every task, if set
+  TaskWrapper wrapper_;
+
+  /// \brief Runs a task through the wrapper if one is set
+  /// \param index Index of the task
+  inline void execute(size_t index)
+  {
+    auto& task = tasks_[index];
+    auto outer = JobPool::context();
+    JobPool::set_context(index);
+    if ( wrapper_ )
+      wrapper_(index, task.name, task.fn);
+    else
+      task.fn();
+    JobPool::set_context(outer);
+  }
+
+  /// \brief Links every task to each earlier task it conflicts with
+  void build_graph();
+
+  /// \brief Submits a task whose dependencies have all finished
+  /// \param index Task to submit
+  /// \param frame Counter tracking all of the frames tasks
+  void submit(size_t index, JobCounter& frame);
+};
+
+}
+
+#endif //ECS_FRAMEWORK_SCHEDULER_HPP
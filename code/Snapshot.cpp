@@ -0,0 +1,219 @@
+//
+// Snapshot.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "Snapshot.hpp"
+
+namespace ecs {
+
+namespace {
+
+/// \brief Number of words covered by each bitmask in a diff
+constexpr size_t block_words = 64;
+
+/// \brief Overwrites a word of a snapshot, adding the XOR of the old and new
+/// word to a diff. Unchanged words are written past the end of the diff and
+/// then overwritten, which keeps the loop free of branches
+/// \param words Snapshot being overwritten
+/// \param out Diff words
+/// \param pos Index of the word to overwrite
+/// \param word New value
+/// \param size Number of diff words used
+/// \param maskAt Index in the diff of the current blocks bitmask
+/// \param mask Bitmask of changed words in the current block
+inline void encode_word(uint64_t* words, uint64_t* out, size_t pos, uint64_t word,
+                        size_t& size, size_t& maskAt, uint64_t& mask)
+{
+  if ( pos % block_words == 0 ) {
+    if ( pos > 0 )
+      out[maskAt] = mask;
+    maskAt = size++;
+    mask = 0;
+  }
+
+  auto changed = words[pos] ^ word;
+  words[pos] = word;
+  out[size] = changed;
+  size += changed != 0;
+  mask |= uint64_t(changed != 0) << (pos % block_words);
+}
+
+}
+
+SnapshotWriter::SnapshotWriter(Snapshot& snapshot, SnapshotDiff& diff)
+  : snapshot_(snapshot), diff_(&diff), oldSize_(snapshot.size_)
+{
+  // Worst case is every word changing, plus a bitmask per block
+  auto worst = oldSize_ + (oldSize_ + block_words - 1) / block_words;
+  if ( diff.words.size() < worst )
+    diff.words.resize(worst);
+
+  diff.size = 0;
+  diff.frameSize = oldSize_;
+  snapshot_.size_ = 0;
+}
+
+void SnapshotWriter::write_diffed(const unsigned char* data, size_t bytes)
+{
+  auto words = snapshot_.words_.data();
+  auto out = diff_->words.data();
+  auto size = diff_->size;
+  auto maskAt = maskAt_;
+  auto mask = mask_;
+
+  auto pos = snapshot_.size_;
+  auto count = (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  auto diffed = std::min(count, oldSize_ - pos);
+  auto whole = std::min(diffed, bytes / sizeof(uint64_t));
+
+  // Whole blocks skip the per-word check for a block boundary
+  size_t i = 0;
+  while ( i < whole ) {
+    auto at = pos + i;
+    auto run = std::min(whole - i, block_words - at % block_words);
+    if ( at % block_words == 0 ) {
+      if ( at > 0 )
+        out[maskAt] = mask;
+      maskAt = size++;
+      mask = 0;
+    }
+
+    for ( size_t k = 0; k < run; ++k ) {
+      uint64_t word;
+      std::memcpy(&word, data + (i + k) * sizeof(uint64_t), sizeof(uint64_t));
+      auto changed = words[at + k] ^ word;
+      words[at + k] = word;
+      out[size] = changed;
+      size += changed != 0;
+      mask |= uint64_t(changed != 0) << ((at + k) % block_words);
+    }
+    i += run;
+  }
+
+  // The last word is only partly filled and padded with zeros
+  if ( diffed > whole ) {
+    uint64_t word = 0;
+    std::memcpy(&word, data + whole * sizeof(uint64_t), bytes % sizeof(uint64_t));
+    encode_word(words, out, pos + whole, word, size, maskAt, mask);
+  }
+
+  diff_->size = size;
+  maskAt_ = maskAt;
+  mask_ = mask;
+  snapshot_.size_ += diffed;
+
+  // Words past the end of the old snapshot have nothing to diff against
+  if ( count > diffed ) {
+    auto offset = diffed * sizeof(uint64_t);
+    auto dest = words + snapshot_.size_;
+    dest[count - diffed - 1] = 0;
+    std::memcpy(dest, data + offset, bytes - offset);
+    snapshot_.size_ += count - diffed;
+  }
+}
+
+void SnapshotWriter::finish()
+{
+  auto words = snapshot_.words_.data();
+  auto out = diff_->words.data();
+  auto size = diff_->size;
+
+  // Old words past the end of the new snapshot are kept whole, as decoding
+  // XORs them with zeros
+  for ( auto pos = snapshot_.size_; pos < oldSize_; ++pos )
+    encode_word(words, out, pos, 0, size, maskAt_, mask_);
+
+  if ( oldSize_ > 0 )
+    out[maskAt_] = mask_;
+
+  diff_->size = size;
+}
+
+SnapshotRing::SnapshotRing(size_t frames, size_t reserveBytes)
+  : diffs_(frames)
+{
+  latest_.reserve(reserveBytes);
+
+  auto words = (reserveBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  for ( auto& diff : diffs_ )
+    diff.words.resize(words + (words + block_words - 1) / block_words);
+}
+
+const Snapshot& SnapshotRing::rewind(size_t frames)
+{
+  frames = std::min(frames, count_);
+  for ( size_t i = 0; i < frames; ++i ) {
+    decode(diffs_[head_], latest_);
+    head_ = (head_ + diffs_.size() - 1) % diffs_.size();
+    count_--;
+  }
+  return latest_;
+}
+
+size_t SnapshotRing::bytes() const
+{
+  auto total = latest_.capacity();
+  for ( auto& diff : diffs_ )
+    total += diff.words.size() * sizeof(uint64_t);
+  return total;
+}
+
+void SnapshotRing::clear()
+{
+  latest_.size_ = 0;
+  count_ = 0;
+  empty_ = true;
+}
+
+void SnapshotRing::decode(const SnapshotDiff& diff, Snapshot& frame)
+{
+  // Words past the end of the newer snapshot may be stale, and were encoded
+  // as if they were zero
+  if ( diff.frameSize > frame.size_ ) {
+    frame.grow(diff.frameSize);
+    std::fill(frame.words_.begin() + frame.size_,
+              frame.words_.begin() + diff.frameSize, 0);
+  }
+
+  auto words = frame.words_.data();
+  auto in = diff.words.data();
+  size_t i = 0;
+
+  for ( size_t base = 0; base < diff.frameSize; base += block_words ) {
+    auto mask = in[i++];
+
+    if ( mask == ~uint64_t(0) ) {
+      for ( size_t k = 0; k < block_words; ++k )
+        words[base + k] ^= in[i + k];
+      i += block_words;
+      continue;
+    }
+
+    // Walking set bits is only worth it for sparse blocks, as each step
+    // depends on the last
+    if ( __builtin_popcountll(mask) > 8 ) {
+      auto end = std::min(block_words, diff.frameSize - base);
+      for ( size_t k = 0; k < end; ++k ) {
+        auto bit = (mask >> k) & 1;
+        words[base + k] ^= in[i] & (uint64_t(0) - bit);
+        i += bit;
+      }
+      continue;
+    }
+
+    while ( mask != 0 ) {
+      words[base + __builtin_ctzll(mask)] ^= in[i++];
+      mask &= mask - 1;
+    }
+  }
+
+  frame.size_ = diff.frameSize;
+}
+
+}
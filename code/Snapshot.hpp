@@ -0,0 +1,334 @@
+//
+// Snapshot.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_SNAPSHOT_HPP
+#define ECS_FRAMEWORK_SNAPSHOT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "Allocator.hpp"
+
+namespace ecs {
+
+/// \brief Arrays in a snapshot, including their length, are padded to a
+/// multiple of this many words so small changes in length don't shift every
+/// array after them, which would make the snapshot diff poorly
+constexpr size_t snapshot_array_words = 512;
+
+/// \brief Snapshot is a flat copy of world state, written by SnapshotWriter
+/// and read back by SnapshotReader. Storage is kept in 8 byte words so
+/// snapshots can be diffed a word at a time, and is never shrunk so writing
+/// a snapshot of a similar size again doesn't allocate
+class Snapshot {
+public:
+  /// \brief Gets the size of the snapshot
+  /// \return Number of bytes written
+  inline size_t size() const { return size_ * sizeof(uint64_t); }
+
+  /// \brief Gets the bytes reserved for the snapshot
+  /// \return Number of bytes that can be written without allocating
+  inline size_t capacity() const { return words_.size() * sizeof(uint64_t); }
+
+  /// \brief Reserves room so the first snapshots don't allocate
+  /// \param bytes Number of bytes to reserve
+  inline void reserve(size_t bytes)
+  {
+    grow((bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+  }
+
+private:
+  friend class SnapshotWriter;
+  friend class SnapshotReader;
+  friend class SnapshotRing;
+
+  /// \brief The snapshot, padded with stale words past size_
+  AlignedVector<uint64_t> words_;
+  /// \brief Number of words written
+  size_t size_ = 0;
+
+  /// \brief Makes sure a number of words are allocated, zeroing only words
+  /// that are new
+  inline void grow(size_t words)
+  {
+    if ( words > words_.size() )
+      words_.resize(std::max(words, words_.size() * 2));
+  }
+};
+
+/// \brief SnapshotDiff is the XOR of a snapshot and the one taken after it,
+/// with unchanged words left out. For each block of 64 words it holds a
+/// bitmask of the words that changed followed by just those words
+struct SnapshotDiff {
+  /// Encoded blocks
+  AlignedVector<uint64_t> words;
+  /// Number of words used
+  size_t size = 0;
+  /// Size of the older snapshot in words
+  size_t frameSize = 0;
+};
+
+/// \brief SnapshotWriter appends arrays of trivially copyable values to a
+/// Snapshot with one copy each. Every array is prefixed with its length and
+/// padded to a whole word
+class SnapshotWriter {
+public:
+  /// \brief Starts a new snapshot, discarding what it held
+  /// \param snapshot Snapshot to write
+  explicit SnapshotWriter(Snapshot& snapshot)
+    : snapshot_(snapshot)
+  {
+    snapshot_.size_ = 0;
+  }
+
+  /// \brief Appends a single value
+  /// \param value Value to write
+  template <typename T>
+  inline void write(const T& value)
+  {
+    write_bytes(&value, sizeof(T));
+  }
+
+  /// \brief Appends an array and its length
+  /// \param values Array to write
+  template <typename T, typename Alloc>
+  inline void write_array(const std::vector<T, Alloc>& values)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable components can be snapshotted");
+
+    auto start = snapshot_.size_;
+    write(static_cast<uint64_t>(values.size()));
+    write_bytes(values.data(), values.size() * sizeof(T));
+    pad(start);
+  }
+
+private:
+  friend class SnapshotRing;
+
+  Snapshot& snapshot_;
+  /// \brief Diff recording the words overwritten, if any
+  SnapshotDiff* diff_ = nullptr;
+  /// \brief Size of the snapshot being overwritten in words
+  size_t oldSize_ = 0;
+  /// \brief Bitmask of changed words in the current block
+  uint64_t mask_ = 0;
+  /// \brief Index in the diff of the current blocks bitmask
+  size_t maskAt_ = 0;
+
+  /// \brief Starts a new snapshot over an old one, recording every word
+  /// overwritten in a diff so the old snapshot can be rebuilt
+  /// \param snapshot Snapshot to overwrite
+  /// \param diff Diff to encode into, its storage is reused
+  SnapshotWriter(Snapshot& snapshot, SnapshotDiff& diff);
+
+  /// \brief Copies bytes to the end of the snapshot, padding the last word
+  inline void write_bytes(const void* data, size_t bytes)
+  {
+    auto words = (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    snapshot_.grow(snapshot_.size_ + words);
+
+    if ( diff_ && snapshot_.size_ < oldSize_ ) {
+      write_diffed(static_cast<const unsigned char*>(data), bytes);
+      return;
+    }
+
+    auto dest = snapshot_.words_.data() + snapshot_.size_;
+    if ( words > 0 ) {
+      dest[words - 1] = 0;
+      std::memcpy(dest, data, bytes);
+    }
+    snapshot_.size_ += words;
+  }
+
+  /// \brief Writes zeros up to the end of an arrays padding
+  /// \param start Word the array started at
+  inline void pad(size_t start)
+  {
+    static const uint64_t zeros[snapshot_array_words] = {};
+    auto used = (snapshot_.size_ - start) % snapshot_array_words;
+    if ( used > 0 )
+      write_bytes(zeros, (snapshot_array_words - used) * sizeof(uint64_t));
+  }
+
+  /// \brief Copies bytes over the old snapshot, encoding the XOR of each old
+  /// and new word
+  void write_diffed(const unsigned char* data, size_t bytes);
+
+  /// \brief Encodes the old words past the end of the new snapshot and
+  /// closes the diff
+  void finish();
+};
+
+/// \brief SnapshotReader reads values back from a Snapshot in the order a
+/// SnapshotWriter wrote them
+class SnapshotReader {
+public:
+  /// \brief Starts reading a snapshot from the beginning
+  /// \param snapshot Snapshot to read
+  explicit SnapshotReader(const Snapshot& snapshot)
+    : snapshot_(snapshot)
+  {}
+
+  /// \brief Reads a single value
+  /// \param value Value to overwrite
+  template <typename T>
+  inline void read(T& value)
+  {
+    read_bytes(&value, sizeof(T));
+  }
+
+  /// \brief Reads an array, resizing the vector to match it
+  /// \param values Vector to overwrite
+  template <typename T, typename Alloc>
+  inline void read_array(std::vector<T, Alloc>& values)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Only trivially copyable components can be snapshotted");
+
+    auto start = offset_;
+    uint64_t count = 0;
+    read(count);
+    values.resize(count);
+    read_bytes(values.data(), count * sizeof(T));
+    skip_padding(start);
+  }
+
+  /// \brief Reads an array in place, without copying it
+  /// \param count Set to the number of values in the array
+  /// \return Pointer to the first value, valid until the snapshot changes
+  template <typename T>
+  inline const T* view_array(size_t& count)
+  {
+    static_assert(alignof(T) <= alignof(uint64_t),
+                  "Arrays are only aligned to a word in a snapshot");
+
+    auto start = offset_;
+    uint64_t saved = 0;
+    read(saved);
+    count = static_cast<size_t>(saved);
+
+    auto values = reinterpret_cast<const T*>(snapshot_.words_.data() + offset_);
+    offset_ += (count * sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    skip_padding(start);
+    return values;
+  }
+
+  /// \brief Checks if everything written has been read
+  /// \return True if the reader is at the end of the snapshot
+  inline bool done() const { return offset_ >= snapshot_.size_; }
+
+private:
+  const Snapshot& snapshot_;
+  /// \brief Word to read next
+  size_t offset_ = 0;
+
+  /// \brief Moves past the padding at the end of an array
+  /// \param start Word the array started at
+  inline void skip_padding(size_t start)
+  {
+    auto used = (offset_ - start) % snapshot_array_words;
+    if ( used > 0 )
+      offset_ += snapshot_array_words - used;
+  }
+
+  /// \brief Copies bytes out of the snapshot, skipping the padding
+  inline void read_bytes(void* data, size_t bytes)
+  {
+    if ( bytes > 0 )
+      std::memcpy(data, snapshot_.words_.data() + offset_, bytes);
+    offset_ += (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  }
+};
+
+/// \brief SnapshotRing keeps the last few snapshots of a world for rollback.
+/// \details Only the newest snapshot is kept whole. Each older one is kept as
+/// a SnapshotDiff against the snapshot after it, built in the same pass that
+/// overwrites the newest snapshot, so frames that changed little cost little
+/// and nothing is copied twice. Every buffer is reused once the ring has
+/// filled, so steady state pushes don't allocate. Arrays that grow or shrink
+/// shift everything after them and diff poorly, so frames with many
+/// structural changes are stored larger
+class SnapshotRing {
+public:
+  /// \brief Creates a ring holding a number of frames
+  /// \param frames Most frames that can be rewound, not counting the newest
+  /// \param reserveBytes Expected size of a snapshot, used to preallocate the
+  /// newest frame and every diff
+  explicit SnapshotRing(size_t frames, size_t reserveBytes = 0);
+
+  /// \brief Saves a world as the newest frame, dropping the oldest if full
+  /// \tparam World Type with a save(SnapshotWriter&) const member, such as
+  /// EntityMap
+  /// \param world World to save
+  template <typename World>
+  void push(const World& world)
+  {
+    if ( empty_ || diffs_.empty() ) {
+      SnapshotWriter writer(latest_);
+      world.save(writer);
+      empty_ = false;
+      return;
+    }
+
+    head_ = (head_ + 1) % diffs_.size();
+    SnapshotWriter writer(latest_, diffs_[head_]);
+    world.save(writer);
+    writer.finish();
+    count_ = std::min(count_ + 1, diffs_.size());
+  }
+
+  /// \brief Gets the newest frame
+  /// \return The last pushed snapshot, empty if nothing was pushed
+  inline const Snapshot& latest() const { return latest_; }
+
+  /// \brief Discards the newest frames, making an older one the newest. The
+  /// diffs are applied in place in one pass each so nothing is copied
+  /// \param frames Number of frames to go back, clamped to size()
+  /// \return The frame now newest
+  const Snapshot& rewind(size_t frames);
+
+  /// \brief Gets the number of frames that can be rewound
+  /// \return Number of diffs held
+  inline size_t size() const { return count_; }
+
+  /// \brief Gets the number of frames the ring can hold
+  /// \return Most frames that can be rewound
+  inline size_t capacity() const { return diffs_.size(); }
+
+  /// \brief Gets the bytes held by the ring
+  /// \return Bytes held by the newest frame and diffs
+  size_t bytes() const;
+
+  /// \brief Discards every frame
+  void clear();
+
+private:
+  Snapshot latest_;
+  std::vector<SnapshotDiff> diffs_;
+  /// \brief Index of the newest diff
+  size_t head_ = 0;
+  size_t count_ = 0;
+  bool empty_ = true;
+
+  /// \brief Turns the newer snapshot a diff was made from back into the
+  /// older
+  /// \param diff Diff to apply
+  /// \param frame Newer snapshot, overwritten with the older one
+  static void decode(const SnapshotDiff& diff, Snapshot& frame);
+};
+
+}
+
+#endif //ECS_FRAMEWORK_SNAPSHOT_HPP
@@ -0,0 +1,89 @@
+//
+// Sprite.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "Sprite.hpp"
+
+#include <cmath>
+
+namespace ecs {
+
+void build_sprite_batches(const sf::Sprite* sprites, size_t count,
+                          std::vector<SpriteBatch>& batches)
+{
+  for ( auto& batch : batches ) {
+    batch.vertices.setPrimitiveType(sf::Quads);
+    batch.vertices.clear();
+  }
+
+  SpriteBatch* batch = nullptr;
+
+  for ( size_t i = 0; i < count; ++i ) {
+    auto& sprite = sprites[i];
+    auto* texture = sprite.getTexture();
+
+    // Consecutive sprites usually share a texture so only search on change
+    if ( batch == nullptr || batch->texture != texture ) {
+      batch = nullptr;
+      for ( auto& existing : batches ) {
+        if ( existing.texture == texture ) {
+          batch = &existing;
+          break;
+        }
+      }
+
+      if ( batch == nullptr ) {
+        batches.push_back(SpriteBatch { texture, sf::VertexArray(sf::Quads) });
+        batch = &batches.back();
+      }
+    }
+
+    auto rect = sprite.getTextureRect();
+    auto width = static_cast<float>(std::abs(rect.width));
+    auto height = static_cast<float>(std::abs(rect.height));
+    auto left = static_cast<float>(rect.left);
+    auto top = static_cast<float>(rect.top);
+    auto right = left + rect.width;
+    auto bottom = top + rect.height;
+
+    auto& transform = sprite.getTransform();
+    auto color = sprite.getColor();
+
+    sf::Vertex corners[4] = {
+      sf::Vertex(transform.transformPoint(0, 0), color, sf::Vector2f(left, top)),
+      sf::Vertex(transform.transformPoint(0, height), color, sf::Vector2f(left, bottom)),
+      sf::Vertex(transform.transformPoint(width, height), color, sf::Vector2f(right, bottom)),
+      sf::Vertex(transform.transformPoint(width, 0), color, sf::Vector2f(right, top))
+    };
+
+    for ( auto& corner : corners )
+      batch->vertices.append(corner);
+  }
+}
+
+void SpriteSystem::render(sf::RenderWindow &window)
+{
+  build_sprite_batches(spriteData.instances.data(), spriteData.instances.size(),
+                       batches);
+
+  for ( auto& batch : batches ) {
+    if ( batch.vertices.getVertexCount() > 0 )
+      window.draw(batch.vertices, sf::RenderStates(batch.texture));
+  }
+}
+
+void SpriteSystem::draw(sf::RenderWindow &window, const SpriteFrame& frame)
+{
+  for ( auto& batch : frame.batches ) {
+    if ( batch.vertices.getVertexCount() > 0 )
+      window.draw(batch.vertices, sf::RenderStates(batch.texture));
+  }
+}
+
+}
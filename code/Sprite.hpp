@@ -0,0 +1,148 @@
+//
+// Sprite.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_SPRITE_HPP
+#define ECS_FRAMEWORK_SPRITE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Entity.hpp"
+
+namespace ecs {
+
+/// \brief SpriteBatch is a quad vertex stream for every sprite sharing a
+/// texture, drawn with a single draw call
+struct SpriteBatch {
+  /// Texture shared by every quad in the batch
+  const sf::Texture* texture;
+  /// Four vertices per sprite, as sf::Quads
+  sf::VertexArray vertices;
+};
+
+/// \brief Builds one batch per texture from an array of sprites. This only
+/// touches CPU memory so it can run without a window or GPU. Batches are
+/// reused between calls to avoid reallocating their vertex storage. Sprites
+/// keep their relative order within a batch, but not across batches
+/// \param sprites Sprites to batch
+/// \param count Number of sprites
+/// \param batches Batches to fill. Existing batches are cleared and reused,
+/// and batches whose texture no longer appears are left empty
+void build_sprite_batches(const sf::Sprite* sprites, size_t count,
+                          std::vector<SpriteBatch>& batches);
+
+/// \brief SpriteFrame is a read-only snapshot of everything needed to draw
+/// the sprites of one frame, so drawing can overlap simulating the next
+struct SpriteFrame {
+  /// Per-texture vertex streams
+  std::vector<SpriteBatch> batches;
+};
+
+/// \brief SpriteSystem operates on a set of sf::Sprite data, rendering them
+/// to an sf::RenderWindow. It isn't scheduled as rendering has to happen on the
+/// thread owning the window, and positions are updated by MovementSystem
+struct SpriteSystem : public System {
+
+  /// Type of component this system operates on
+  using component_type = sf::Sprite;
+
+  /// Sprite data to operate on
+  ComponentData<sf::Sprite> spriteData;
+
+  /// Per-texture vertex streams built by render()
+  std::vector<SpriteBatch> batches;
+
+  /// \brief Gets the component data this system operates on
+  /// \return The sprite data
+  inline ComponentData<sf::Sprite>& components() { return spriteData; }
+
+  /// \brief Adds a new entity to this systems component data.
+  /// \param entity Entity to add
+  inline void add(const Entity& entity) override
+  {
+    spriteData.attach(entity);
+  }
+
+  /// \brief Adds a range of entities to this systems component data.
+  /// \param entities First entity to add
+  /// \param count Number of entities to add
+  inline void add_many(const Entity* entities, size_t count) override
+  {
+    spriteData.attach(entities, count);
+  }
+
+  /// \brief Removes an entity from this systems component data.
+  /// \param entity Entity to remove
+  inline void remove(const Entity& entity) override
+  {
+    spriteData.detach(entity);
+  }
+
+  /// \brief Checks if this system contains a specified entity
+  /// \param entity Entity to check for
+  /// \return True if has entity, false otherwise
+  inline bool has_entity(const Entity& entity) override
+  {
+    return spriteData.has_component(entity);
+  }
+
+  /// \brief Gets the memory held by the sprite data
+  /// \return The sprite data stats
+  inline MemoryStats memory() const override { return spriteData.memory(); }
+
+  /// \brief Frees unused capacity in the sprite data
+  inline void shrink_to_fit() override { spriteData.shrink_to_fit(); }
+
+  /// \brief Moves all sprites 1px down and to the right, splitting the
+  /// sprites across the shared job pool
+  void move()
+  {
+    spriteData.parallel_for([](const Entity&, sf::Sprite& sprite) {
+      sprite.move(1, 1);
+    });
+  }
+
+  /// \brief Moves sprites sharing a texture next to each other a few swaps at
+  /// a time, so batches are built from runs rather than scattered sprites
+  /// after churn
+  /// \param maxSwaps Most swaps to make this call
+  /// \return True if the sprites are grouped by texture
+  inline bool sort_by_texture(size_t maxSwaps)
+  {
+    return spriteData.sort_step([](const sf::Sprite& sprite) {
+      return sprite.getTexture();
+    }, maxSwaps);
+  }
+
+  /// \brief Renders all sprites to a window with one draw call per texture
+  /// \param window Window to render to
+  void render(sf::RenderWindow &window);
+
+  /// \brief Builds a snapshot of the sprites for draw(). Doesn't touch the
+  /// window so it can run on any thread
+  /// \param frame Snapshot to fill, its storage is reused
+  inline void prepare(SpriteFrame& frame) const
+  {
+    build_sprite_batches(spriteData.instances.data(), spriteData.instances.size(),
+                         frame.batches);
+  }
+
+  /// \brief Draws a snapshot from prepare() with one draw call per texture.
+  /// Reads nothing but the snapshot, so sprites can be changed meanwhile
+  /// \param window Window to render to
+  /// \param frame Snapshot to draw
+  static void draw(sf::RenderWindow &window, const SpriteFrame& frame);
+};
+
+}
+
+#endif //ECS_FRAMEWORK_SPRITE_HPP
@@ -0,0 +1,73 @@
+//
+// Transform.cpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#include "Transform.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ecs {
+
+void integrate(float* x, float* y, const float* vx, const float* vy,
+               size_t count, float dt)
+{
+  size_t i = 0;
+
+#if defined(__AVX__)
+  auto step = _mm256_set1_ps(dt);
+  for ( ; i + 8 <= count; i += 8 ) {
+    auto px = _mm256_loadu_ps(x + i);
+    auto py = _mm256_loadu_ps(y + i);
+    px = _mm256_add_ps(px, _mm256_mul_ps(_mm256_loadu_ps(vx + i), step));
+    py = _mm256_add_ps(py, _mm256_mul_ps(_mm256_loadu_ps(vy + i), step));
+    _mm256_storeu_ps(x + i, px);
+    _mm256_storeu_ps(y + i, py);
+  }
+#elif defined(__SSE2__)
+  auto step = _mm_set1_ps(dt);
+  for ( ; i + 4 <= count; i += 4 ) {
+    auto px = _mm_loadu_ps(x + i);
+    auto py = _mm_loadu_ps(y + i);
+    px = _mm_add_ps(px, _mm_mul_ps(_mm_loadu_ps(vx + i), step));
+    py = _mm_add_ps(py, _mm_mul_ps(_mm_loadu_ps(vy + i), step));
+    _mm_storeu_ps(x + i, px);
+    _mm_storeu_ps(y + i, py);
+  }
+#endif
+
+  for ( ; i < count; ++i ) {
+    x[i] += vx[i] * dt;
+    y[i] += vy[i] * dt;
+  }
+}
+
+void MovementSystem::update()
+{
+  auto& t = transforms;
+  parallel_for(t.x.data(), t.size(), 16384, [&](size_t begin, size_t end) {
+    integrate(t.x.data() + begin, t.y.data() + begin,
+              t.vx.data() + begin, t.vy.data() + begin, end - begin, timestep);
+  });
+}
+
+void MovementSystem::sync(ComponentData<sf::Sprite>& sprites)
+{
+  auto& entities = transforms.entities();
+  for ( size_t i = 0; i < entities.size(); ++i ) {
+    auto* sprite = sprites.get(entities[i]);
+    if ( sprite != nullptr )
+      sprite->setPosition(transforms.x[i], transforms.y[i]);
+  }
+}
+
+}
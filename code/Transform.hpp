@@ -0,0 +1,348 @@
+//
+// Transform.hpp
+// ECS_Framework
+//
+// ----------------------------------------------------------------------------
+//
+// Created by Jacob Milligan on 16/10/2026.
+// Copyright (c) 2026 Jacob Milligan All rights reserved.
+//
+
+#ifndef ECS_FRAMEWORK_TRANSFORM_HPP
+#define ECS_FRAMEWORK_TRANSFORM_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Entity.hpp"
+
+namespace ecs {
+
+/// \brief Transform is an entities position and velocity in the world
+struct Transform {
+  sf::Vector2f position;
+  sf::Vector2f velocity;
+};
+
+/// \brief Integrates positions by their velocities over a timestep using the
+/// widest vector instructions available at compile time (AVX, then SSE, then
+/// scalar). Arrays don't need to be aligned
+/// \param x Position x coordinates, updated in place
+/// \param y Position y coordinates, updated in place
+/// \param vx Velocity x components
+/// \param vy Velocity y components
+/// \param count Number of elements in each array
+/// \param dt Timestep to integrate over
+void integrate(float* x, float* y, const float* vx, const float* vy,
+               size_t count, float dt);
+
+/// \brief TransformData stores Transform components as a structure of arrays,
+/// keeping each field in its own contiguous array so the movement kernel only
+/// touches the floats it needs
+struct TransformData {
+
+  /// Type of component stored
+  using value_type = Transform;
+  /// Pointer-like handle to a transform, as returned by EntityMap::get()
+  using pointer = SoaPointer<TransformData>;
+
+  /// Position x coordinates
+  AlignedVector<float> x;
+  /// Position y coordinates
+  AlignedVector<float> y;
+  /// Velocity x components
+  AlignedVector<float> vx;
+  /// Velocity y components
+  AlignedVector<float> vy;
+
+  /// \brief Gets an entities transform
+  /// \param entity The entity whose transform is being retrieved
+  /// \return The transform, or a zero transform if the entity has none
+  inline Transform get(const Entity& entity) const
+  {
+    auto index = entities_.index_of(entity);
+    if ( index == SparseSet::null_index )
+      return Transform();
+
+    return gather(index);
+  }
+
+  /// \brief Sets an entities transform. Does nothing if the entity has none
+  /// \param entity The entity whose transform is being set
+  /// \param transform The new transform
+  inline void set(const Entity& entity, const Transform& transform)
+  {
+    auto index = entities_.index_of(entity);
+    if ( index == SparseSet::null_index )
+      return;
+
+    scatter(index, transform);
+  }
+
+  /// \brief Gets a transform by index
+  /// \param index Index of the transform
+  /// \return The transform
+  inline Transform gather(size_t index) const
+  {
+    Transform transform;
+    transform.position = sf::Vector2f(x[index], y[index]);
+    transform.velocity = sf::Vector2f(vx[index], vy[index]);
+    return transform;
+  }
+
+  /// \brief Sets a transform by index
+  /// \param index Index of the transform
+  /// \param transform The new transform
+  inline void scatter(size_t index, const Transform& transform)
+  {
+    x[index] = transform.position.x;
+    y[index] = transform.position.y;
+    vx[index] = transform.velocity.x;
+    vy[index] = transform.velocity.y;
+  }
+
+  /// \brief Does nothing, transforms aren't versioned. Lets TransformData
+  /// be used by EntityMap::get() and views
+  inline void touch(size_t) {}
+
+  /// \brief Splits the transform indices into ranges that run in parallel on
+  /// a job pool, starting on a cache line of every array
+  /// \param fn Function called as fn(begin, end) for each range
+  /// \param grain Target number of transforms per job
+  /// \param pool Pool to run jobs on
+  template <typename Fn>
+  void parallel_ranges(Fn&& fn, size_t grain = 4096, JobPool& pool = JobPool::shared())
+  {
+    ecs::parallel_for(x.data(), size(), grain, fn, pool);
+  }
+
+  /// \brief Gets a handle to a transform by index that writes it back when
+  /// destroyed
+  /// \param index Index of the transform
+  /// \return Handle to the transform
+  inline pointer component_at(size_t index) { return pointer(this, index); }
+
+  /// \brief Checks to see if the entity has a transform
+  /// \param entity To check for
+  /// \return True if found, false otherwise
+  inline bool has_component(const Entity& entity) const
+  {
+    return entities_.contains(entity);
+  }
+
+  /// \brief Attaches a zero transform to an entity
+  /// \param entity Entity to attach
+  inline void attach(const Entity& entity)
+  {
+    x.push_back(0);
+    y.push_back(0);
+    vx.push_back(0);
+    vy.push_back(0);
+    entities_.insert(entity);
+  }
+
+  /// \brief Attaches a zeroed transform to each of a range of entities,
+  /// growing each array once
+  /// \param entities First entity to attach
+  /// \param count Number of entities to attach
+  inline void attach(const Entity* entities, size_t count)
+  {
+    auto first = x.size();
+    x.resize(first + count, 0);
+    y.resize(first + count, 0);
+    vx.resize(first + count, 0);
+    vy.resize(first + count, 0);
+    entities_.insert(entities, count);
+  }
+
+  /// \brief Reserves room in every array so attaching up to capacity doesn't
+  /// reallocate
+  /// \param capacity Number of transforms to reserve room for
+  inline void reserve(size_t capacity)
+  {
+    x.reserve(capacity);
+    y.reserve(capacity);
+    vx.reserve(capacity);
+    vy.reserve(capacity);
+    entities_.reserve(capacity);
+  }
+
+  /// \brief Removes an entities transform by moving the last transform into
+  /// its place. Does nothing if the entity has no transform
+  /// \param entity Entity to remove
+  inline void detach(const Entity& entity)
+  {
+    auto index = entities_.erase(entity);
+    if ( index == SparseSet::null_index )
+      return;
+
+    x[index] = x.back();
+    y[index] = y.back();
+    vx[index] = vx.back();
+    vy[index] = vy.back();
+    x.pop_back();
+    y.pop_back();
+    vx.pop_back();
+    vy.pop_back();
+  }
+
+  /// \brief Gets the memory held by the arrays
+  /// \return The containers stats
+  MemoryStats memory() const
+  {
+    MemoryStats stats;
+    stats.count = size();
+    stats.capacity = x.capacity();
+    stats.dense_bytes = (x.capacity() + y.capacity() + vx.capacity() + vy.capacity()) * sizeof(float);
+    stats.slack_bytes = ((x.capacity() - x.size()) + (y.capacity() - y.size()) + (vx.capacity() - vx.size()) + (vy.capacity() - vy.size())) * sizeof(float);
+    entities_.memory(stats);
+    return stats;
+  }
+
+  /// \brief Frees unused capacity and empty sparse pages
+  void shrink_to_fit()
+  {
+    x.shrink_to_fit();
+    y.shrink_to_fit();
+    vx.shrink_to_fit();
+    vy.shrink_to_fit();
+    entities_.shrink_to_fit();
+  }
+
+  /// \brief Writes every array and the entity owning each transform
+  /// \param writer Snapshot to write to
+  void save(SnapshotWriter& writer) const
+  {
+    writer.write_array(x);
+    writer.write_array(y);
+    writer.write_array(vx);
+    writer.write_array(vy);
+    entities_.save(writer);
+  }
+
+  /// \brief Replaces every transform with those from save()
+  /// \param reader Snapshot to read from
+  void load(SnapshotReader& reader)
+  {
+    reader.read_array(x);
+    reader.read_array(y);
+    reader.read_array(vx);
+    reader.read_array(vy);
+    entities_.load(reader);
+  }
+
+  /// \brief Gets the entities owning each transform, in array order
+  /// \return The dense entity array
+  inline const std::vector<Entity>& entities() const
+  {
+    return entities_.entities();
+  }
+
+  /// \brief Gets the array index of an entities transform
+  /// \param entity Entity to look up
+  /// \return The index if found, SparseSet::null_index otherwise
+  inline EntityId index_of(const Entity& entity) const
+  {
+    return entities_.index_of(entity);
+  }
+
+  /// \brief Gets the number of transforms stored
+  /// \return Number of transforms
+  inline size_t size() const { return x.size(); }
+
+private:
+  /// \brief Sparse set used to index into the arrays
+  SparseSet entities_;
+};
+
+/// \brief MovementSystem integrates Transform positions by their velocities
+/// each frame. Sprites aren't touched until sync() copies the positions into
+/// them just before rendering
+struct MovementSystem : public System {
+
+  /// Type of component this system operates on
+  using component_type = Transform;
+
+  /// Storage the transforms are kept in
+  using storage_type = TransformData;
+
+  /// Transform data to operate on
+  TransformData transforms;
+
+  /// Timestep used by update()
+  float timestep = 1.0f;
+
+  /// \brief Adds a new entity to this systems component data.
+  /// \param entity Entity to add
+  inline void add(const Entity& entity) override
+  {
+    transforms.attach(entity);
+  }
+
+  /// \brief Gets the transform data, so the system can be used with
+  /// EntityMap::get() and views like one storing ComponentData
+  /// \return The transforms
+  inline TransformData& components() { return transforms; }
+
+  /// \brief Adds a range of entities to this systems component data.
+  /// \param entities First entity to add
+  /// \param count Number of entities to add
+  inline void add_many(const Entity* entities, size_t count) override
+  {
+    transforms.attach(entities, count);
+  }
+
+  /// \brief Removes an entity from this systems component data.
+  /// \param entity Entity to remove
+  inline void remove(const Entity& entity) override
+  {
+    transforms.detach(entity);
+  }
+
+  /// \brief Checks if this system contains a specified entity
+  /// \param entity Entity to check for
+  /// \return True if has entity, false otherwise
+  inline bool has_entity(const Entity& entity) override
+  {
+    return transforms.has_component(entity);
+  }
+
+  /// \brief Declares write access to transforms for update()
+  /// \param access Access to add Transform to
+  inline void declare_access(Access& access) override
+  {
+    access.writes |= component_mask<Transform>();
+  }
+
+  /// \brief Gets the memory held by the transform data
+  /// \return The transform data stats
+  inline MemoryStats memory() const override { return transforms.memory(); }
+
+  /// \brief Frees unused capacity in the transform data
+  inline void shrink_to_fit() override { transforms.shrink_to_fit(); }
+
+  /// \brief Writes the transforms to a snapshot
+  /// \param writer Snapshot to write to
+  inline void save(SnapshotWriter& writer) const override { transforms.save(writer); }
+
+  /// \brief Checks if save() writes the systems components
+  /// \return Always true
+  inline bool saves_components() const override { return true; }
+
+  /// \brief Restores the transforms from a snapshot
+  /// \param reader Snapshot to read from
+  inline void load(SnapshotReader& reader) override { transforms.load(reader); }
+
+  /// \brief Integrates every position by one timestep
+  void update() override;
+
+  /// \brief Copies every entities position into its sprite
+  /// \param sprites Sprite data to update
+  void sync(ComponentData<sf::Sprite>& sprites);
+};
+
+}
+
+#endif //ECS_FRAMEWORK_TRANSFORM_HPP
@@ -8,6 +8,9 @@ plt.rcParams["font.family"] = "Helvetica Light"
 
 df = pd.read_csv('cache.csv')
 
+# There's no portable L2 miss counter, so the L2Proxy column is last level
+# cache references per instruction rather than a measured L2 miss rate
+
 pos = list(range(len(df['L3'])))
 width = 0.25
 
@@ -40,7 +43,7 @@ plt.bar([p + width for p in pos],
         label=df['System'][1])
 
 plt.bar([p + width for p in pos],
-        df['L2'],
+        df['L2Proxy'],
         width,
         alpha=0.5,
         color='#03A9F4',
@@ -63,7 +66,7 @@ ax1.set_xticklabels(df['System'])
 plt.xlim(min(pos) - width, max(pos) + width * 4)
 
 # Adding the legend and showing the plot
-legend = plt.legend(['iCache Misses', 'L1 Cache Misses', 'L2 Cache Misses', 'L3 Cache Misses'],
+legend = plt.legend(['iCache Misses', 'L1 Cache Misses', 'L2 Misses (proxy: LLC references)', 'L3 Cache Misses'],
                     loc='upper left')
 frame = legend.get_frame()
 frame.set_facecolor('1')
@@ -73,18 +76,18 @@ plt.savefig('individual.eps', format='eps', dpi=1000)
 # Draw combined systems
 plt.rc('xtick', labelsize=12)
 
-benchmark = df[['iCache', 'L1', 'L2', 'L3']].iloc[[0]].mean(axis=0)
-ecs = df[['iCache', 'L1', 'L2', 'L3']].iloc[[1, 2, 3]].mean(axis=0)
-oo = df[['iCache', 'L1', 'L2', 'L3']].iloc[[4, 5, 6]].mean(axis=0)
+benchmark = df[['iCache', 'L1', 'L2Proxy', 'L3']].iloc[[0]].mean(axis=0)
+ecs = df[['iCache', 'L1', 'L2Proxy', 'L3']].iloc[[1, 2, 3]].mean(axis=0)
+oo = df[['iCache', 'L1', 'L2Proxy', 'L3']].iloc[[4, 5, 6]].mean(axis=0)
 
 rawCombined = {'function': ['benchmark', 'ecs', 'oop'],
                'iCache': [benchmark['iCache'], ecs['iCache'], oo['iCache']],
                "L1": [benchmark['L1'], ecs['L1'], oo['L1']],
-               'L2': [benchmark['L2'], ecs['L2'], oo['L2']],
+               'L2Proxy': [benchmark['L2Proxy'], ecs['L2Proxy'], oo['L2Proxy']],
                'L3': [benchmark['L3'], ecs['L3'], oo['L3']]
                }
 
-dfCombined = pd.DataFrame(rawCombined, columns=['function', 'iCache', 'L1', 'L2', 'L3'])
+dfCombined = pd.DataFrame(rawCombined, columns=['function', 'iCache', 'L1', 'L2Proxy', 'L3'])
 
 pos = list(range(len(dfCombined['L3'])))
 width = 0.2
@@ -116,7 +119,7 @@ plt.bar([p + width for p in pos],
         label=dfCombined['function'][1])
 
 plt.bar([p + width * 2 for p in pos],
-        dfCombined['L2'],
+        dfCombined['L2Proxy'],
         width,
         alpha=0.5,
         color='#00BCD4',
@@ -139,7 +142,7 @@ ax2.set_xticklabels(dfCombined['function'])
 plt.xlim(min(pos) - width, max(pos) + width * 4)
 
 # Adding the legend and showing the plot
-legend = plt.legend(['iCache Misses', 'L1 Cache Misses', 'L2 Cache Misses', 'L3 Cache Misses'],
+legend = plt.legend(['iCache Misses', 'L1 Cache Misses', 'L2 Misses (proxy: LLC references)', 'L3 Cache Misses'],
                     loc='upper left')
 frame = legend.get_frame()
 frame.set_facecolor('1')
@@ -148,7 +151,7 @@ for x, y in zip(pos, dfCombined['iCache']):
     ax2.text(x + + 0.1, y + 0.0003, '%.3f' % y , ha='center', va='bottom')
 for x, y in zip(pos, dfCombined['L1']):
     ax2.text(x + 0.3, y + 0.0003, '%.3f' % y , ha='center', va='bottom')
-for x, y in zip(pos, dfCombined['L2']):
+for x, y in zip(pos, dfCombined['L2Proxy']):
     ax2.text(x + 0.5, y + 0.0003, '%.3f' % y , ha='center', va='bottom')
 for x, y in zip(pos, dfCombined['L3']):
     ax2.text(x + 0.7, y + 0.0003, '%.3f' % y , ha='center', va='bottom')
@@ -193,9 +196,23 @@ plt.savefig('combined.eps', format='eps', dpi=1000)
 # Runtimes #
 ############
 dfRuntime = pd.read_csv('data.csv')
+
+# Headless benchmark output sweeps entity counts, plot the largest
+if 'Entities' in dfRuntime:
+    dfRuntime = dfRuntime.loc[dfRuntime['Entities'] == dfRuntime['Entities'].max()]
+    dfRuntime = dfRuntime.drop('Entities', axis=1)
+
+# The baselines are single threaded, so label the ECS if it used more threads
+ecsLabel = 'ECS'
+if 'Threads' in dfRuntime:
+    ecsThreads = dfRuntime.loc[dfRuntime['Experiment'] == 2, 'Threads'].max()
+    if ecsThreads > 1:
+        ecsLabel = 'ECS (%d threads)' % ecsThreads
+    dfRuntime = dfRuntime.drop('Threads', axis=1)
+
 dfRuntime['Experiment'] = dfRuntime['Experiment'].astype('category')
 dfRuntime['Experiment'] = dfRuntime['Experiment'].cat.rename_categories(
-    ['Benchmark', 'OOP', 'ECS']
+    ['Benchmark', 'OOP', ecsLabel]
 )
 
 dfRuntime['Average Frame Time'] = dfRuntime['Average Frame Time'].apply(
@@ -243,7 +260,7 @@ fig5, ax5 = plt.subplots(figsize=(10, 5))
 
 a = dfRuntime.loc[dfRuntime['Experiment'] == 'Benchmark']
 b = dfRuntime.loc[dfRuntime['Experiment'] == 'OOP']
-c = dfRuntime.loc[dfRuntime['Experiment'] == 'ECS']
+c = dfRuntime.loc[dfRuntime['Experiment'] == ecsLabel]
 
 print a['Average Frame Time'].mean(axis=0), a['Average Frame Time'].median(axis=0), a['Average Frame Time'].std(axis=0)
 print b['Average Frame Time'].mean(axis=0), b['Average Frame Time'].median(axis=0), b['Average Frame Time'].std(axis=0)
@@ -267,7 +284,7 @@ plt.ylabel('Frequency')
 plt.title('Histogram of Frame-Time per test')
 
 # Adding the legend and showing the plot
-legend = plt.legend(['Benchmark', 'OOP', 'ECS'],
+legend = plt.legend(['Benchmark', 'OOP', ecsLabel],
                     loc='upper center')
 frame = legend.get_frame()
 frame.set_facecolor('1')